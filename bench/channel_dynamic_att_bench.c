@@ -0,0 +1,174 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Micro benchmark of the dynamic attenuation channel hot path.
+ *
+ * Links the real channel and client library against the stubs in ./stubs, and for a grid of
+ * device counts, active transmitter densities and command injection rates measures:
+ *   - startup_ns:         time spent in channel_init()
+ *   - ns_per_calc:        time per channel_calc(), including applying the injected commands
+ *   - calls_per_s:        channel_calc() calls per second, the inverse of ns_per_calc
+ *   - cmds_applied_per_s: injected commands divided by the time spent in channel_calc()
+ *   - peak_rss_kb:        peak resident memory so far for this device count
+ *
+ * Commands are sent with the client library through the real fifo (or shared memory ring when
+ * -shm is given). Each device count runs in its own process so peak RSS is per device count.
+ * Results are printed as one JSON object per line on stdout.
+ *
+ * Usage: channel_dynamic_att_bench [channel arguments, e.g. -st=sparse, -shm or -check_interval=100]
+ */
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "bs_types.h"
+#include "channel_if.h"
+#include "channel_dynamic_att_client.h"
+
+#define BENCH_MIN_TIME_NS  (100*1000*1000LL)
+#define BENCH_MAX_CHANNEL_ARGS (32)
+
+extern char *pb_com_path;
+extern uint global_device_nbr;
+
+static const uint bench_device_counts[] = {2, 4, 8, 64, 512, 2048, 8192, 16384};
+static const uint bench_active_percent[] = {0, 10, 100}; /* 0 means a single transmitter */
+static const uint bench_cmds_per_calc[] = {0, 1, 16};
+
+static long long bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
+
+static long bench_peak_rss_kb(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static uint32_t bench_random(void)
+{
+    static uint32_t state = 2463534242U;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static void bench_device_count(uint num_devices, int argc, char *argv[], bool use_shm)
+{
+    uint *tx_used = calloc(num_devices, sizeof(uint));
+    double *att = calloc(num_devices, sizeof(double));
+    tx_el_t *tx_list = calloc(num_devices, sizeof(tx_el_t));
+    long long startup_ns;
+    bs_time_t now = 0U;
+    double isi;
+
+    if (!tx_used || !att || !tx_list) {
+        fprintf(stderr, "Out of memory for %u devices\n", num_devices);
+        exit(1);
+    }
+
+    startup_ns = bench_now_ns();
+    channel_init(argc, argv, num_devices);
+    startup_ns = bench_now_ns() - startup_ns;
+
+    if (use_shm) {
+        channel_dynamic_att_client_open_shm(NULL);
+    } else {
+        channel_dynamic_att_client_open(NULL);
+    }
+
+    for (size_t a = 0U; a < sizeof(bench_active_percent)/sizeof(bench_active_percent[0]); a++) {
+        uint active = 0U;
+
+        for (uint tx = 0U; tx < num_devices; tx++) {
+            tx_used[tx] = bench_active_percent[a] ? (bench_random() % 100U < bench_active_percent[a]) : (tx == num_devices/2U);
+            active += tx_used[tx] ? 1U : 0U;
+        }
+
+        for (size_t r = 0U; r < sizeof(bench_cmds_per_calc)/sizeof(bench_cmds_per_calc[0]); r++) {
+            long long calc_ns = 0;
+            long long start = bench_now_ns();
+            unsigned long long calcs = 0U;
+            unsigned long long cmds = 0U;
+
+            do {
+                for (uint c = 0U; c < bench_cmds_per_calc[r]; c++) {
+                    uint peer = bench_random() % num_devices;
+
+                    global_device_nbr = (peer + 1U + bench_random() % (num_devices - 1U)) % num_devices;
+                    channel_dynamic_att_client_set_attenuation_one(peer, bench_random() % 100U, bench_random() % 100U);
+                }
+                cmds += bench_cmds_per_calc[r];
+
+                long long calc_start = bench_now_ns();
+                channel_calc(tx_used, tx_list, 0U, bench_random() % num_devices, now, att, &isi);
+                calc_ns += bench_now_ns() - calc_start;
+                calcs++;
+                now += 10U;
+            } while (bench_now_ns() - start < BENCH_MIN_TIME_NS);
+
+            printf("{\"num_devices\": %u, \"active_tx\": %u, \"cmds_per_calc\": %u, \"startup_ns\": %lld, "
+                   "\"ns_per_calc\": %.1f, \"calls_per_s\": %.0f, \"cmds_applied_per_s\": %.0f, \"peak_rss_kb\": %ld}\n",
+                   num_devices, active, bench_cmds_per_calc[r], startup_ns,
+                   (double)calc_ns/calcs, calc_ns ? calcs*1e9/calc_ns : 0.0, calc_ns ? cmds*1e9/calc_ns : 0.0, bench_peak_rss_kb());
+            fflush(stdout);
+        }
+    }
+
+    channel_dynamic_att_client_close();
+    channel_delete();
+    free(tx_used);
+    free(att);
+    free(tx_list);
+}
+
+int main(int argc, char *argv[])
+{
+    char com_path[] = "/tmp/dynamic_att_bench.XXXXXX";
+    char *channel_argv[BENCH_MAX_CHANNEL_ARGS] = {"-s=bench"};
+    int channel_argc = 1;
+    bool use_shm = false;
+
+    for (int i = 1; i < argc && channel_argc < BENCH_MAX_CHANNEL_ARGS; i++) {
+        channel_argv[channel_argc++] = argv[i];
+        use_shm |= !strcmp(argv[i], "-shm");
+    }
+
+    pb_com_path = mkdtemp(com_path);
+    if (!pb_com_path) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    for (size_t d = 0U; d < sizeof(bench_device_counts)/sizeof(bench_device_counts[0]); d++) {
+        pid_t child = fork();
+        int status;
+
+        if (child == 0) {
+            bench_device_count(bench_device_counts[d], channel_argc, channel_argv, use_shm);
+            exit(0);
+        }
+        if (child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "Benchmark for %u devices failed\n", bench_device_counts[d]);
+            return 1;
+        }
+    }
+
+    rmdir(pb_com_path);
+    return 0;
+}
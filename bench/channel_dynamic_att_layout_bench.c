@@ -0,0 +1,131 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Compare the attenuation lookup of channel_calc() for the old Tx-major matrix layout
+ * (one strided column walk per receiver) against the Rx-major layout (one contiguous row per
+ * receiver), with both the generic scalar and the SIMD kernel the channel selects for the host CPU.
+ * The calls per second gained by the selected kernel are the difference between the rx_major and
+ * rx_major_scalar rows.
+ *
+ * Output is CSV on stdout: layout,kernel,num_devices,active_tx,ns_per_calc,calls_per_s
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "channel_dynamic_att_gather.h"
+
+#define BENCH_MIN_TIME_NS (200*1000*1000LL)
+
+static long long bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
+
+/* The pre Rx-major lookup: matrix[tx][rx] walked down the rx column */
+static void bench_gather_tx_major(const double *matrix, unsigned int num_devices, unsigned int rx,
+                                  const unsigned int *tx_used, double *att)
+{
+    for (unsigned int tx = 0U; tx < num_devices; tx++) {
+        if (tx_used[tx]) {
+            att[tx] = matrix[(size_t)tx*num_devices + rx];
+        }
+    }
+}
+
+static void bench_gather_rx_major_scalar(const double *matrix, unsigned int num_devices, unsigned int rx,
+                                         const unsigned int *tx_used, double *att)
+{
+    channel_dynamic_att_gather_scalar(matrix + (size_t)rx*num_devices, tx_used, num_devices, att);
+}
+
+static void bench_gather_rx_major(const double *matrix, unsigned int num_devices, unsigned int rx,
+                                  const unsigned int *tx_used, double *att)
+{
+    channel_dynamic_att_gather(matrix + (size_t)rx*num_devices, tx_used, num_devices, att);
+}
+
+typedef void (*bench_gather_t)(const double *matrix, unsigned int num_devices, unsigned int rx,
+                               const unsigned int *tx_used, double *att);
+
+static const struct {
+    const char    *name;
+    bench_gather_t gather;
+} bench_layouts[] = {
+    {"tx_major",        bench_gather_tx_major},
+    {"rx_major_scalar", bench_gather_rx_major_scalar},
+    {"rx_major",        bench_gather_rx_major},
+};
+
+/* The layout is picked by the caller, so all layouts pay the same indirect call in the timed loop */
+static double bench_run(bench_gather_t gather, const double *matrix, unsigned int num_devices,
+                        const unsigned int *tx_used, double *att)
+{
+    long long start = bench_now_ns();
+    long long elapsed;
+    unsigned long long calcs = 0U;
+    unsigned int rx = 0U;
+
+    do {
+        for (unsigned int i = 0U; i < 1024U; i++) {
+            /* Step through receivers in a cache unfriendly order, like independent devices do */
+            rx = (rx + 7919U) % num_devices;
+            gather(matrix, num_devices, rx, tx_used, att);
+        }
+        calcs += 1024U;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < BENCH_MIN_TIME_NS);
+
+    return (double)elapsed / calcs;
+}
+
+int main(void)
+{
+    static const unsigned int device_counts[] = {2, 4, 8, 64, 512, 2048, 4096};
+    static const unsigned int active_percent[] = {0, 10, 100};
+
+    channel_dynamic_att_gather_init();
+    printf("layout,kernel,num_devices,active_tx,ns_per_calc,calls_per_s\n");
+
+    for (size_t d = 0U; d < sizeof(device_counts)/sizeof(device_counts[0]); d++) {
+        unsigned int num_devices = device_counts[d];
+        double *matrix = malloc(sizeof(double)*num_devices*num_devices);
+        unsigned int *tx_used = calloc(num_devices, sizeof(unsigned int));
+        double *att = calloc(num_devices, sizeof(double));
+
+        if (!matrix || !tx_used || !att) {
+            fprintf(stderr, "Out of memory for %u devices\n", num_devices);
+            return 1;
+        }
+        for (size_t i = 0U; i < (size_t)num_devices*num_devices; i++) {
+            matrix[i] = (double)(i % 100U);
+        }
+
+        for (size_t a = 0U; a < sizeof(active_percent)/sizeof(active_percent[0]); a++) {
+            unsigned int active = 0U;
+
+            for (unsigned int tx = 0U; tx < num_devices; tx++) {
+                /* 0% still means one transmitter, which is the common case in a simulation */
+                tx_used[tx] = active_percent[a] ? ((tx*100U/num_devices) % (100U/active_percent[a]) == 0U) : (tx == num_devices/2U);
+                active += tx_used[tx] ? 1U : 0U;
+            }
+            for (size_t l = 0U; l < sizeof(bench_layouts)/sizeof(bench_layouts[0]); l++) {
+                double ns = bench_run(bench_layouts[l].gather, matrix, num_devices, tx_used, att);
+
+                printf("%s,%s,%u,%u,%.2f,%.0f\n", bench_layouts[l].name,
+                       bench_layouts[l].gather == bench_gather_rx_major ? channel_dynamic_att_gather_kernel_name() : "scalar",
+                       num_devices, active, ns, 1e9/ns);
+            }
+        }
+        free(matrix);
+        free(tx_used);
+        free(att);
+    }
+    return 0;
+}
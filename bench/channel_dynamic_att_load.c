@@ -0,0 +1,585 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Load generator for the dynamic attenuation channel command stream.
+ *
+ * The parent process runs the real channel, evaluating it back to back with the simulation time
+ * following the wall clock in microseconds. K forked client processes, each a different
+ * global_device_nbr, send a mix of RESET / SET_ATT_ALL / SET_ATT_ONE commands at a target rate
+ * through the client library, as plain commands or (-mix=...:at) all scheduled for the current time
+ * with the _at functions.
+ *
+ * Each client keeps one acknowledgement in flight behind its commands. When the channel has applied
+ * it, the time from sending it until it was applied is the send to apply latency of the commands
+ * sent just before it.
+ *
+ * Every attenuation sent encodes its client and a per client sequence number. The channel records
+ * a journal (-record) of the commands in the order it applied them, and at the end:
+ *   - commands applied are compared with commands sent, per command (lost or duplicated),
+ *   - the journal must hold each client's commands in the order they were sent (desynced),
+ *   - the final matrix must equal the journal replayed with last-writer-wins (mismatched links).
+ *
+ * Results are printed as one JSON object on stdout, and the exit code is non-zero if a check
+ * failed.
+ *
+ * Usage: channel_dynamic_att_load [-n=<devices>] [-k=<clients>] [-rate=<commands/s per client, 0: unpaced>]
+ *                                 [-duration=<s>] [-mix=<reset>:<all>:<one>[:at]] [-mode=<fifo|shm|async|shm_async>]
+ *                                 [channel arguments]
+ */
+#define _XOPEN_SOURCE 700
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "bs_types.h"
+#include "channel_if.h"
+#include "channel_dynamic_att_client.h"
+#include "channel_dynamic_att_com_protocol.h"
+#include "channel_dynamic_att_defaults.h"
+#include "channel_dynamic_att_journal_format.h"
+#include "channel_dynamic_att_shm_ring.h"
+#include "channel_dynamic_att_stats.h"
+#include "channel_dynamic_att_stats_format.h"
+
+#define LOAD_MAX_CHANNEL_ARGS (32)
+#define LOAD_CALC_BUCKETS     (40)      /* log2 histogram of channel_calc() time in ns */
+#define LOAD_LATENCY_BUCKETS  (32)      /* log2 histogram of send to apply latency in us */
+#define LOAD_ACK_TIMEOUT_MS   (1000U)   /* Wait for the last acknowledgement of a client */
+#define LOAD_DRAIN_CALCS      (10000U)  /* Evaluations without new data before the stream counts as drained */
+#define LOAD_CODE_SCALE       (1048576.0)
+
+extern char *pb_com_path;
+extern uint global_device_nbr;
+
+typedef enum {
+    LOAD_CMD_RESET = 0,
+    LOAD_CMD_ALL,
+    LOAD_CMD_ONE,
+    LOAD_CMD_KINDS
+} load_cmd_t;
+
+static const unsigned short load_cmd_protocol[LOAD_CMD_KINDS] = {
+    DYNAMIC_ATT_PROTOCOL_CMD_RESET, DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL, DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE
+};
+
+/* Written by each client process to its result pipe when done */
+typedef struct {
+    uint64_t sent[LOAD_CMD_KINDS];
+    uint64_t failed;
+    uint64_t dropped;
+    uint64_t elapsed_ns;
+    uint64_t latency[LOAD_LATENCY_BUCKETS];
+} load_client_result_t;
+
+static struct {
+    uint   num_devices;
+    uint   num_clients;
+    double rate;
+    double duration;
+    uint   mix[LOAD_CMD_KINDS];
+    bool   at_time;
+    char  *mode;
+    char  *channel_argv[LOAD_MAX_CHANNEL_ARGS];
+    int    channel_argc;
+} load_args = {
+    .num_devices = 64U,
+    .num_clients = 8U,
+    .rate        = 0.0,
+    .duration    = 2.0,
+    .mix         = {1U, 9U, 90U},
+    .mode        = "fifo",
+};
+
+static long long load_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
+
+static uint32_t load_random(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/*
+ * Attenuation carrying a client and its sequence number, exact in a double
+ */
+static double load_encode(uint client, uint64_t seq, double half)
+{
+    return ((double)(seq*load_args.num_clients + client) + half)/LOAD_CODE_SCALE;
+}
+
+static void load_decode(double attenuation, uint *client, uint64_t *seq)
+{
+    uint64_t code = (uint64_t)(attenuation*LOAD_CODE_SCALE);
+
+    *client = code % load_args.num_clients;
+    *seq = code / load_args.num_clients;
+}
+
+static void load_parse_args(int argc, char *argv[])
+{
+    char *channel_record = NULL;
+
+    load_args.channel_argv[load_args.channel_argc++] = "-s=load";
+    for (int i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "-n=", 3)) {
+            load_args.num_devices = strtoul(argv[i] + 3, NULL, 0);
+        } else if (!strncmp(argv[i], "-k=", 3)) {
+            load_args.num_clients = strtoul(argv[i] + 3, NULL, 0);
+        } else if (!strncmp(argv[i], "-rate=", 6)) {
+            load_args.rate = atof(argv[i] + 6);
+        } else if (!strncmp(argv[i], "-duration=", 10)) {
+            load_args.duration = atof(argv[i] + 10);
+        } else if (!strncmp(argv[i], "-mix=", 5)) {
+            int length = 0;
+
+            if (sscanf(argv[i] + 5, "%u:%u:%u%n", &load_args.mix[LOAD_CMD_RESET], &load_args.mix[LOAD_CMD_ALL], &load_args.mix[LOAD_CMD_ONE], &length) != 3 ||
+                (argv[i][5 + length] != '\0' && strcmp(argv[i] + 5 + length, ":at"))) {
+                fprintf(stderr, "-mix needs <reset>:<all>:<one> weights, optionally followed by :at\n");
+                exit(2);
+            }
+            /* Not mixed with plain commands, which the channel applies before scheduled ones */
+            load_args.at_time = argv[i][5 + length] != '\0';
+        } else if (!strncmp(argv[i], "-mode=", 6)) {
+            load_args.mode = argv[i] + 6;
+        } else if (load_args.channel_argc < LOAD_MAX_CHANNEL_ARGS - 1) {
+            channel_record = !strncmp(argv[i], "-record=", 8) ? argv[i] : channel_record;
+            load_args.channel_argv[load_args.channel_argc++] = argv[i];
+        }
+    }
+
+    if (channel_record) {
+        fprintf(stderr, "The load generator records its own journal, -record cannot be given\n");
+        exit(2);
+    }
+    if (load_args.num_clients < 1U || load_args.num_devices < 2U || load_args.num_clients > load_args.num_devices) {
+        fprintf(stderr, "Need 1 <= k <= n clients and n >= 2 devices\n");
+        exit(2);
+    }
+    if (load_args.mix[LOAD_CMD_RESET] + load_args.mix[LOAD_CMD_ALL] + load_args.mix[LOAD_CMD_ONE] == 0U) {
+        fprintf(stderr, "-mix needs at least one non zero weight\n");
+        exit(2);
+    }
+    if (strcmp(load_args.mode, "fifo") && strcmp(load_args.mode, "shm") && strcmp(load_args.mode, "async") &&
+        strcmp(load_args.mode, "shm_async")) {
+        fprintf(stderr, "-mode must be fifo, shm, async or shm_async\n");
+        exit(2);
+    }
+    if (!strcmp(load_args.mode, "shm") || !strcmp(load_args.mode, "shm_async")) {
+        load_args.channel_argv[load_args.channel_argc++] = "-shm";
+    }
+}
+
+static void load_add_latency(uint64_t *histogram, bs_time_t apply_time, bs_time_t sent_time)
+{
+    /*
+     * The channel takes its time before evaluating, so a command sent while an evaluation is
+     * running can be applied at a time before it was sent
+     */
+    bs_time_t latency = apply_time > sent_time ? apply_time - sent_time : 0U;
+    uint bucket = 0U;
+
+    while (latency && bucket < LOAD_LATENCY_BUCKETS - 1U) {
+        latency >>= 1;
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+/*
+ * One client process: send commands until the duration has passed
+ */
+static void load_client(uint client, long long start_ns, int result_fd)
+{
+    load_client_result_t result = {0};
+    long long interval_ns = load_args.rate > 0.0 ? (long long)(1e9/load_args.rate) : 0;
+    long long end_ns = start_ns + (long long)(load_args.duration*1e9);
+    long long next_ns = load_now_ns();
+    uint mix_total = load_args.mix[LOAD_CMD_RESET] + load_args.mix[LOAD_CMD_ALL] + load_args.mix[LOAD_CMD_ONE];
+    uint32_t random_state = 2463534242U + client*7919U;
+    uint64_t seq = 0U;
+    bs_time_t ack_sent_us = TIME_NEVER;
+    bs_time_t apply_time;
+    uint32_t ack_sequence = 0U;
+    bool opened;
+
+    global_device_nbr = client;
+    if (!strcmp(load_args.mode, "shm")) {
+        opened = channel_dynamic_att_client_open_shm(NULL);
+    } else if (!strcmp(load_args.mode, "async")) {
+        opened = channel_dynamic_att_client_open_async(NULL, DYNAMIC_ATT_CLIENT_DEFAULT_QUEUE_SIZE, DYNAMIC_ATT_CLIENT_QUEUE_BLOCK);
+    } else if (!strcmp(load_args.mode, "shm_async")) {
+        opened = channel_dynamic_att_client_open_shm_async(NULL, DYNAMIC_ATT_CLIENT_DEFAULT_QUEUE_SIZE, DYNAMIC_ATT_CLIENT_QUEUE_BLOCK);
+    } else {
+        opened = channel_dynamic_att_client_open(NULL);
+    }
+    if (!opened) {
+        fprintf(stderr, "Client %u could not connect\n", client);
+        _exit(1);
+    }
+
+    while (load_now_ns() < end_ns) {
+        uint pick = load_random(&random_state) % mix_total;
+        bs_time_t now_us = (bs_time_t)((load_now_ns() - start_ns)/1000);
+        load_cmd_t kind;
+        bool sent;
+
+        kind = pick < load_args.mix[LOAD_CMD_RESET] ? LOAD_CMD_RESET :
+               pick < load_args.mix[LOAD_CMD_RESET] + load_args.mix[LOAD_CMD_ALL] ? LOAD_CMD_ALL : LOAD_CMD_ONE;
+        seq++;
+        if (kind == LOAD_CMD_RESET) {
+            sent = load_args.at_time ? channel_dynamic_att_client_reset_at(now_us) : channel_dynamic_att_client_reset();
+        } else if (kind == LOAD_CMD_ALL) {
+            double attenuation = load_encode(client, seq, 0.0);
+
+            sent = load_args.at_time ? channel_dynamic_att_client_set_attenuation_all_at(now_us, attenuation) :
+                                       channel_dynamic_att_client_set_attenuation_all(attenuation);
+        } else {
+            uint peer = (client + 1U + load_random(&random_state) % (load_args.num_devices - 1U)) % load_args.num_devices;
+            double attenuation_tx = load_encode(client, seq, 0.0);
+            double attenuation_rx = load_encode(client, seq, 0.5);
+
+            sent = load_args.at_time ? channel_dynamic_att_client_set_attenuation_one_at(now_us, peer, attenuation_tx, attenuation_rx) :
+                                       channel_dynamic_att_client_set_attenuation_one(peer, attenuation_tx, attenuation_rx);
+        }
+        if (sent) {
+            result.sent[kind]++;
+        } else {
+            result.failed++;
+        }
+
+        if (ack_sent_us != TIME_NEVER && channel_dynamic_att_client_is_applied(ack_sequence, &apply_time)) {
+            load_add_latency(result.latency, apply_time, ack_sent_us);
+            ack_sent_us = TIME_NEVER;
+        }
+        if (ack_sent_us == TIME_NEVER &&
+            (load_args.at_time ? channel_dynamic_att_client_request_ack_at(now_us, &ack_sequence) :
+                                 channel_dynamic_att_client_request_ack(&ack_sequence))) {
+            ack_sent_us = now_us;
+        }
+
+        if (interval_ns) {
+            struct timespec ts;
+
+            next_ns += interval_ns;
+            ts.tv_sec = next_ns / 1000000000LL;
+            ts.tv_nsec = next_ns % 1000000000LL;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+    }
+
+    if (ack_sent_us != TIME_NEVER) {
+        apply_time = channel_dynamic_att_client_wait_applied(ack_sequence, LOAD_ACK_TIMEOUT_MS);
+        if (apply_time != TIME_NEVER) {
+            load_add_latency(result.latency, apply_time, ack_sent_us);
+        }
+    }
+    channel_dynamic_att_client_close();
+    result.dropped = channel_dynamic_att_client_dropped();
+    result.elapsed_ns = load_now_ns() - start_ns;
+    _exit(write(result_fd, &result, sizeof(result)) == sizeof(result) ? 0 : 1);
+}
+
+/*
+ * Upper bound of the bucket holding the given fraction of all samples of a log2 histogram
+ */
+static uint64_t load_percentile(const uint64_t *histogram, uint buckets, double fraction)
+{
+    uint64_t total = 0U;
+    uint64_t count = 0U;
+
+    for (uint i = 0U; i < buckets; i++) {
+        total += histogram[i];
+    }
+    for (uint i = 0U; i < buckets; i++) {
+        count += histogram[i];
+        if (total && count >= fraction*total) {
+            return i ? 1ULL << i : 0U;
+        }
+    }
+    return 0U;
+}
+
+/*
+ * Apply the journal to a plain matrix with last-writer-wins, and check each client's commands
+ * were applied in the order they were sent
+ */
+static void load_replay_journal(const char *file_name, double *expected, double default_attenuation,
+                                uint64_t applied[LOAD_CMD_KINDS], uint64_t *desynced)
+{
+    uint num_devices = load_args.num_devices;
+    uint64_t *last_seq = calloc(load_args.num_clients, sizeof(uint64_t));
+    ch_dynamic_att_journal_header_t header;
+    FILE *file = fopen(file_name, "rb");
+
+    if (!file || !last_seq || fread(&header, sizeof(header), 1, file) != 1 || header.magic != DYNAMIC_ATT_JOURNAL_MAGIC) {
+        fprintf(stderr, "Could not read the journal %s\n", file_name);
+        exit(1);
+    }
+
+    for (size_t i = 0U; i < (size_t)num_devices*num_devices; i++) {
+        expected[i] = default_attenuation;
+    }
+
+    for (;;) {
+        unsigned char record[sizeof(uint64_t) + DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE];
+        const ch_dynamic_att_com_protocol_packet_t *packet = (const ch_dynamic_att_com_protocol_packet_t *)(record + sizeof(uint64_t));
+        const size_t fixed_size = sizeof(uint64_t) + sizeof(ch_dynamic_att_com_protocol_header_t);
+        uint device, peer, client;
+        uint64_t seq;
+        double attenuation;
+
+        if (fread(record, fixed_size, 1, file) != 1) {
+            break;
+        }
+        if (packet->header.payload_size > DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE - sizeof(packet->header) ||
+            fread(record + fixed_size, 1, packet->header.payload_size, file) != packet->header.payload_size) {
+            fprintf(stderr, "Truncated journal record\n");
+            (*desynced)++;
+            break;
+        }
+
+        switch (packet->header.command) {
+            case DYNAMIC_ATT_PROTOCOL_CMD_RESET:
+                applied[LOAD_CMD_RESET]++;
+                for (size_t i = 0U; i < (size_t)num_devices*num_devices; i++) {
+                    expected[i] = default_attenuation;
+                }
+                continue;
+            case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL:
+                applied[LOAD_CMD_ALL]++;
+                device = packet->payload.set_att_all_payload.device;
+                attenuation = packet->payload.set_att_all_payload.attenuation;
+                for (uint dev = 0U; dev < num_devices; dev++) {
+                    expected[(size_t)device*num_devices + dev] = attenuation;
+                    expected[(size_t)dev*num_devices + device] = attenuation;
+                }
+                break;
+            case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE:
+                applied[LOAD_CMD_ONE]++;
+                device = packet->payload.set_att_one_payload.device;
+                peer = packet->payload.set_att_one_payload.peer_device;
+                attenuation = packet->payload.set_att_one_payload.attenuation_rx;
+                /* expected is Rx major, like the channel matrix */
+                expected[(size_t)device*num_devices + peer] = attenuation;
+                expected[(size_t)peer*num_devices + device] = packet->payload.set_att_one_payload.attenuation_tx;
+                break;
+            default:
+                fprintf(stderr, "Unexpected command %u in the journal\n", packet->header.command);
+                (*desynced)++;
+                continue;
+        }
+
+        load_decode(attenuation, &client, &seq);
+        if (client != device || seq <= last_seq[client]) {
+            (*desynced)++;
+        } else {
+            last_seq[client] = seq;
+        }
+    }
+
+    fclose(file);
+    free(last_seq);
+}
+
+int main(int argc, char *argv[])
+{
+    char com_path[] = "/tmp/dynamic_att_load.XXXXXX";
+    char journal_path[sizeof(com_path) + 16];
+    char record_arg[sizeof(journal_path) + 16];
+    char file_path[sizeof(com_path) + sizeof(DYNAMIC_ATT_DEFAULT_FIFO_NAME) + 16];
+    uint64_t calc_histogram[LOAD_CALC_BUCKETS] = {0};
+    uint64_t latency[LOAD_LATENCY_BUCKETS] = {0};
+    uint64_t lateness[DYNAMIC_ATT_STATS_LATENESS_BUCKETS];
+    uint64_t sent[LOAD_CMD_KINDS] = {0};
+    uint64_t received[LOAD_CMD_KINDS] = {0};
+    uint64_t applied[LOAD_CMD_KINDS] = {0};
+    uint64_t failed = 0U, dropped = 0U, desynced = 0U, mismatched = 0U, malformed;
+    uint64_t calcs = 0U, last_bytes_read = 0U, total_sent = 0U, total_applied = 0U;
+    uint idle_calcs = 0U, running;
+    load_client_result_t *results;
+    int *result_fds;
+    long long start_ns, end_ns, max_calc_ns = 0;
+    double default_attenuation, isi;
+    double *att, *expected, *final;
+    uint *tx_used;
+    tx_el_t *tx_list;
+    pid_t *children;
+    bool failed_client = false;
+
+    load_parse_args(argc, argv);
+
+    pb_com_path = mkdtemp(com_path);
+    if (!pb_com_path) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(journal_path, sizeof(journal_path), "%s/load.journal", pb_com_path);
+    snprintf(record_arg, sizeof(record_arg), "-record=%s", journal_path);
+    load_args.channel_argv[load_args.channel_argc++] = record_arg;
+
+    tx_used = malloc(load_args.num_devices*sizeof(uint));
+    tx_list = calloc(load_args.num_devices, sizeof(tx_el_t));
+    att = calloc(load_args.num_devices, sizeof(double));
+    expected = malloc((size_t)load_args.num_devices*load_args.num_devices*sizeof(double));
+    final = malloc((size_t)load_args.num_devices*load_args.num_devices*sizeof(double));
+    children = calloc(load_args.num_clients, sizeof(pid_t));
+    results = calloc(load_args.num_clients, sizeof(load_client_result_t));
+    result_fds = calloc(load_args.num_clients, sizeof(int));
+    if (!tx_used || !tx_list || !att || !expected || !final || !children || !results || !result_fds) {
+        fprintf(stderr, "Out of memory for %u devices\n", load_args.num_devices);
+        return 1;
+    }
+    for (uint tx = 0U; tx < load_args.num_devices; tx++) {
+        tx_used[tx] = 1U;
+    }
+
+    channel_init(load_args.channel_argc, load_args.channel_argv, load_args.num_devices);
+    channel_calc(tx_used, tx_list, 0U, 0U, 0U, att, &isi);
+    default_attenuation = att[1];
+
+    start_ns = load_now_ns();
+    for (uint client = 0U; client < load_args.num_clients; client++) {
+        int fds[2];
+
+        if (pipe(fds)) {
+            perror("pipe");
+            return 1;
+        }
+        children[client] = fork();
+        if (children[client] == 0) {
+            close(fds[0]);
+            load_client(client, start_ns, fds[1]);
+        }
+        if (children[client] < 0) {
+            perror("fork");
+            return 1;
+        }
+        close(fds[1]);
+        result_fds[client] = fds[0];
+    }
+
+    /* Evaluate the channel until all clients are done and their commands are drained */
+    running = load_args.num_clients;
+    while (running || idle_calcs < LOAD_DRAIN_CALCS) {
+        bs_time_t now_us = (bs_time_t)((load_now_ns() - start_ns)/1000);
+        long long calc_ns = load_now_ns();
+        uint bucket = 0U;
+
+        channel_calc(tx_used, tx_list, 0U, calcs % load_args.num_devices, now_us, att, &isi);
+        calc_ns = load_now_ns() - calc_ns;
+        while (bucket < LOAD_CALC_BUCKETS - 1U && (1LL << bucket) < calc_ns) {
+            bucket++;
+        }
+        calc_histogram[bucket]++;
+        max_calc_ns = calc_ns > max_calc_ns ? calc_ns : max_calc_ns;
+        calcs++;
+
+        if (ch_dynamic_att_stats->bytes_read != last_bytes_read) {
+            last_bytes_read = ch_dynamic_att_stats->bytes_read;
+            idle_calcs = 0U;
+        } else if (!running) {
+            idle_calcs++;
+        }
+        if (running && (calcs % 1024U) == 0U) {
+            for (uint client = 0U; client < load_args.num_clients; client++) {
+                int status;
+
+                if (children[client] > 0 && waitpid(children[client], &status, WNOHANG) == children[client]) {
+                    failed_client |= !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+                                     read(result_fds[client], &results[client], sizeof(load_client_result_t)) != sizeof(load_client_result_t);
+                    close(result_fds[client]);
+                    children[client] = 0;
+                    running--;
+                }
+            }
+        }
+    }
+    end_ns = load_now_ns();
+
+    for (uint kind = 0U; kind < LOAD_CMD_KINDS; kind++) {
+        received[kind] = ch_dynamic_att_stats->commands[load_cmd_protocol[kind]];
+    }
+    malformed = ch_dynamic_att_stats->malformed;
+    memcpy(lateness, ch_dynamic_att_stats->lateness, sizeof(lateness));
+
+    /* Read back the final matrix, one Rx row per evaluation */
+    for (uint rx = 0U; rx < load_args.num_devices; rx++) {
+        channel_calc(tx_used, tx_list, 0U, rx, (bs_time_t)((load_now_ns() - start_ns)/1000), final + (size_t)rx*load_args.num_devices, &isi);
+    }
+    /* Closes the journal */
+    channel_delete();
+
+    load_replay_journal(journal_path, expected, default_attenuation, applied, &desynced);
+    for (uint rx = 0U; rx < load_args.num_devices; rx++) {
+        for (uint tx = 0U; tx < load_args.num_devices; tx++) {
+            if (tx != rx && final[(size_t)rx*load_args.num_devices + tx] != expected[(size_t)rx*load_args.num_devices + tx]) {
+                mismatched++;
+            }
+        }
+    }
+
+    for (uint client = 0U; client < load_args.num_clients; client++) {
+        for (uint kind = 0U; kind < LOAD_CMD_KINDS; kind++) {
+            sent[kind] += results[client].sent[kind];
+        }
+        failed += results[client].failed;
+        dropped += results[client].dropped;
+        for (uint i = 0U; i < LOAD_LATENCY_BUCKETS; i++) {
+            latency[i] += results[client].latency[i];
+        }
+    }
+    for (uint kind = 0U; kind < LOAD_CMD_KINDS; kind++) {
+        total_sent += sent[kind];
+        total_applied += applied[kind];
+        desynced += received[kind] > applied[kind] ? received[kind] - applied[kind] : applied[kind] - received[kind];
+    }
+
+    printf("{\"mode\": \"%s\", \"at_time\": %s, \"num_devices\": %u, \"clients\": %u, \"target_rate\": %.0f, \"duration_s\": %.3f, "
+           "\"sent\": [%"PRIu64", %"PRIu64", %"PRIu64"], \"applied\": [%"PRIu64", %"PRIu64", %"PRIu64"], "
+           "\"cmds_per_s\": %.0f, \"failed\": %"PRIu64", \"dropped\": %"PRIu64", \"lost\": %"PRId64", "
+           "\"desynced\": %"PRIu64", \"malformed\": %"PRIu64", \"mismatched_links\": %"PRIu64", "
+           "\"apply_latency_us\": {\"p50\": %"PRIu64", \"p99\": %"PRIu64", \"p999\": %"PRIu64"}, "
+           "\"scheduled_lateness_us\": {\"p50\": %"PRIu64", \"p99\": %"PRIu64", \"p999\": %"PRIu64"}, "
+           "\"calcs\": %"PRIu64", \"calc_ns\": {\"p50\": %"PRIu64", \"p99\": %"PRIu64", \"max\": %lld}}\n",
+           load_args.mode, load_args.at_time ? "true" : "false", load_args.num_devices, load_args.num_clients, load_args.rate, (end_ns - start_ns)/1e9,
+           sent[LOAD_CMD_RESET], sent[LOAD_CMD_ALL], sent[LOAD_CMD_ONE],
+           applied[LOAD_CMD_RESET], applied[LOAD_CMD_ALL], applied[LOAD_CMD_ONE],
+           total_applied*1e9/(end_ns - start_ns), failed, dropped, (int64_t)(total_sent - total_applied),
+           desynced, malformed, mismatched,
+           load_percentile(latency, LOAD_LATENCY_BUCKETS, 0.5),
+           load_percentile(latency, LOAD_LATENCY_BUCKETS, 0.99),
+           load_percentile(latency, LOAD_LATENCY_BUCKETS, 0.999),
+           load_percentile(lateness, DYNAMIC_ATT_STATS_LATENESS_BUCKETS, 0.5),
+           load_percentile(lateness, DYNAMIC_ATT_STATS_LATENESS_BUCKETS, 0.99),
+           load_percentile(lateness, DYNAMIC_ATT_STATS_LATENESS_BUCKETS, 0.999),
+           calcs, load_percentile(calc_histogram, LOAD_CALC_BUCKETS, 0.5), load_percentile(calc_histogram, LOAD_CALC_BUCKETS, 0.99),
+           max_calc_ns);
+
+    remove(journal_path);
+    snprintf(file_path, sizeof(file_path), "%s/%s%s", pb_com_path, DYNAMIC_ATT_DEFAULT_FIFO_NAME, DYNAMIC_ATT_SHM_RING_SUFFIX);
+    remove(file_path);
+    rmdir(pb_com_path);
+    free(result_fds);
+    free(results);
+    free(children);
+    free(final);
+    free(expected);
+    free(att);
+    free(tx_list);
+    free(tx_used);
+
+    return (failed_client || total_sent != total_applied || desynced || malformed || mismatched) ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Minimal implementations of the BabbleSim functions and variables used by the channel and the
+ * client library, so the benchmarks run without a BabbleSim tree.
+ */
+#define _XOPEN_SOURCE 700
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "bs_pc_base.h"
+#include "bs_cmd_line.h"
+
+char *pb_com_path;
+uint global_device_nbr;
+int bench_trace_level;
+
+void bs_trace_error(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    fprintf(stderr, "ERROR: ");
+    vfprintf(stderr, format, args);
+    va_end(args);
+    exit(1);
+}
+
+void bs_trace_warning(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    fprintf(stderr, "WARNING: ");
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void bs_trace_raw(int level, const char *format, ...)
+{
+    va_list args;
+
+    if (level > bench_trace_level) {
+        return;
+    }
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void *bs_calloc(size_t count, size_t size)
+{
+    return calloc(count, size);
+}
+
+void *bs_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void *bs_realloc(void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+int pb_create_com_folder(const char *sim_id)
+{
+    (void)sim_id;
+    mkdir(pb_com_path, 0700);
+    return strlen(pb_com_path);
+}
+
+int pb_create_fifo_if_not_there(const char *fifo_path)
+{
+    struct stat fifo_stat;
+
+    if (stat(fifo_path, &fifo_stat) == 0) {
+        return S_ISFIFO(fifo_stat.st_mode) ? 0 : -1;
+    }
+    return mkfifo(fifo_path, 0600);
+}
+
+void bs_args_override_exe_name(char *name)
+{
+    (void)name;
+}
+
+void bs_args_set_trace_prefix(char *prefix)
+{
+    (void)prefix;
+}
+
+/*
+ * Accepts -<option>=<value> and -<name>=<value>, and -<option> for switches
+ */
+void bs_args_parse_all_cmd_line(int argc, char *argv[], bs_args_struct_t args_struct[])
+{
+    for (int i = 0; i < argc; i++) {
+        const char *arg = (argv[i][0] == '-') ? argv[i] + 1 : argv[i];
+        bs_args_struct_t *match = NULL;
+        const char *value = NULL;
+
+        for (bs_args_struct_t *entry = args_struct; entry->option || entry->name; entry++) {
+            const char *names[] = {entry->option, entry->name};
+
+            for (int n = 0; n < 2 && !match; n++) {
+                size_t length = names[n] ? strlen(names[n]) : 0;
+
+                if (length && !strncmp(arg, names[n], length) && (arg[length] == '=' || arg[length] == '\0')) {
+                    match = entry;
+                    value = arg[length] ? arg + length + 1 : NULL;
+                }
+            }
+            if (match) {
+                break;
+            }
+        }
+        if (!match) {
+            bs_trace_error("Unknown argument %s\n", argv[i]);
+        }
+        if (match->call_when_found) {
+            match->call_when_found(argv[i], 0);
+        }
+        if (!match->dest) {
+            continue;
+        }
+        if (!match->is_switch && !value) {
+            bs_trace_error("Argument %s needs a value\n", argv[i]);
+        }
+        switch (match->type) {
+            case 's':
+                *(char **)match->dest = (char *)value;
+                break;
+            case 'f':
+                *(double *)match->dest = atof(value);
+                break;
+            case 'u':
+                *(uint *)match->dest = strtoul(value, NULL, 0);
+                break;
+            case 'U':
+                *(uint64_t *)match->dest = strtoull(value, NULL, 0);
+                break;
+            case 'b':
+                *(bool *)match->dest = true;
+                break;
+            default:
+                bs_trace_error("Unsupported argument type %c\n", match->type);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Minimal stand in for the BabbleSim libUtilv1 header, for building the benchmarks without a
+ * BabbleSim tree. Only what the channel uses is provided.
+ */
+#ifndef BS_CMD_LINE_H
+#define BS_CMD_LINE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct {
+    bool  manual;
+    bool  is_mandatory;
+    bool  is_switch;
+    char *option;
+    char *name;
+    char  type;
+    void *dest;
+    void (*call_when_found)(char *argv, int offset);
+    char *descript;
+} bs_args_struct_t;
+
+#define ARG_TABLE_ENDMARKER {false, false, false, NULL, NULL, 0, NULL, NULL, NULL}
+
+void bs_args_parse_all_cmd_line(int argc, char *argv[], bs_args_struct_t args_struct[]);
+void bs_args_override_exe_name(char *name);
+void bs_args_set_trace_prefix(char *prefix);
+
+#endif /* BS_CMD_LINE_H */
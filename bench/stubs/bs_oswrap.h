@@ -0,0 +1,20 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Minimal stand in for the BabbleSim libUtilv1 header, for building the benchmarks without a
+ * BabbleSim tree. Only what the channel uses is provided.
+ */
+#ifndef BS_OSWRAP_H
+#define BS_OSWRAP_H
+
+#include <stdlib.h>
+#include <unistd.h>
+
+void *bs_calloc(size_t count, size_t size);
+void *bs_malloc(size_t size);
+void *bs_realloc(void *ptr, size_t size);
+
+#endif /* BS_OSWRAP_H */
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Minimal stand in for the BabbleSim libPhyComv1 header, for building the benchmarks without a
+ * BabbleSim tree. Only what the channel uses is provided.
+ */
+#ifndef BS_PC_BASE_H
+#define BS_PC_BASE_H
+
+int pb_create_com_folder(const char *sim_id);
+int pb_create_fifo_if_not_there(const char *fifo_path);
+
+#endif /* BS_PC_BASE_H */
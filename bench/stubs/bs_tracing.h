@@ -0,0 +1,24 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Minimal stand in for the BabbleSim libUtilv1 header, for building the benchmarks without a
+ * BabbleSim tree. Only what the channel uses is provided.
+ */
+#ifndef BS_TRACING_H
+#define BS_TRACING_H
+
+#include <stdio.h>
+
+void bs_trace_error(const char *format, ...);
+void bs_trace_warning(const char *format, ...);
+void bs_trace_raw(int level, const char *format, ...);
+
+#define bs_trace_error_line(...)        bs_trace_error(__VA_ARGS__)
+#define bs_trace_error_line_time(...)   bs_trace_error(__VA_ARGS__)
+#define bs_trace_warning_line(...)      bs_trace_warning(__VA_ARGS__)
+#define bs_trace_warning_line_time(...) bs_trace_warning(__VA_ARGS__)
+
+#endif /* BS_TRACING_H */
@@ -0,0 +1,23 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Minimal stand in for the BabbleSim libUtilv1 header, for building the benchmarks without a
+ * BabbleSim tree. Only what the channel uses is provided.
+ */
+#ifndef BS_TYPES_H
+#define BS_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+typedef unsigned int uint;
+typedef uint64_t bs_time_t;
+
+#define TIME_NEVER UINT64_MAX
+#define PRItime PRIu64
+
+#endif /* BS_TYPES_H */
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+ * Minimal stand in for the ext_2G4_phy_v1 channel interface, for building the benchmarks
+ * without a BabbleSim tree. Only the transmission fields the channel reads are provided.
+ */
+#ifndef CHANNEL_IF_H
+#define CHANNEL_IF_H
+
+#include "bs_types.h"
+
+typedef int16_t  p2G4_freq_t;
+typedef uint16_t p2G4_modulation_t;
+
+typedef struct {
+    p2G4_modulation_t modulation;
+    p2G4_freq_t       center_freq;
+} p2G4_radioparams_t;
+
+typedef struct {
+    bs_time_t          start_tx_time;
+    bs_time_t          end_tx_time;
+    p2G4_radioparams_t radio_params;
+} p2G4_txv2_t;
+
+typedef struct {
+    p2G4_txv2_t tx_s;
+} tx_el_t;
+
+int  channel_init(int argc, char *argv[], uint n_devs);
+int  channel_calc(const uint *tx_used, tx_el_t *tx_list, uint txnbr, uint rxnbr, bs_time_t now, double *att, double *ISI_SNR);
+void channel_delete(void);
+
+#endif /* CHANNEL_IF_H */
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_ACK_FORMAT_H
+#define _CHANNEL_DYNAMIC_ATT_ACK_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Ack page
+ *
+ * The channel creates a file in the simulation com folder, named as the fifo with
+ * DYNAMIC_ATT_ACK_SUFFIX appended, holding this header followed by one entry per device. When it
+ * applies a CMD_ACK it writes the sequence number and the simulation time to the entry of the
+ * device which sent it, through a shared mapping. Clients map the file read only and poll their
+ * own entry. The channel creates a new file in channel_init(), replacing any file left from an
+ * earlier run, and deletes it in channel_delete().
+ *
+ * Each entry is only written by the channel, as a sequence lock: version is incremented to an odd
+ * value, sequence and apply_time are written, and version is incremented to an even value again
+ * with release ordering. A reader loads version with acquire ordering, reads the entry, and reads
+ * version again; if either read of version was odd or they differ the entry was being written and
+ * the read is retried.
+ *
+ * The page is not created when replaying a journal.
+ */
+
+#define DYNAMIC_ATT_ACK_MAGIC   (0x4B434144) /* "DACK" */
+#define DYNAMIC_ATT_ACK_VERSION (1)
+#define DYNAMIC_ATT_ACK_SUFFIX  ".ack"
+
+typedef struct {
+    uint32_t version;    /* Sequence lock, odd while the entry is being written */
+    uint32_t sequence;   /* Sequence number of the last CMD_ACK applied for the device, 0 if none */
+    uint64_t apply_time; /* Simulation time in microseconds it was applied at */
+} ch_dynamic_att_ack_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_devices;
+    uint32_t reserved;
+    /* Followed by num_devices ch_dynamic_att_ack_entry_t */
+} ch_dynamic_att_ack_header_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_ACK_FORMAT_H */
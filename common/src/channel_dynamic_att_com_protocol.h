@@ -6,6 +6,8 @@
 #ifndef _CHANNEL_DYNAMIC_ATT_COM_PROTOCOL_H
 #define _CHANNEL_DYNAMIC_ATT_COM_PROTOCOL_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -13,6 +15,29 @@ extern "C" {
 #define DYNAMIC_ATT_PROTOCOL_CMD_RESET       (0x0000)
 #define DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL (0x0001)
 #define DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE (0x0002)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX  (0x0003)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_RX  (0x0004)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_LST (0x0005)
+#define DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME     (0x0006)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP     (0x0007)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP_ATT (0x0008)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT    (0x0009)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_BIN (0x000A)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ALL (0x000B)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ONE (0x000C)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_POS     (0x000D)
+#define DYNAMIC_ATT_PROTOCOL_CMD_SET_OFFSET  (0x000E)
+#define DYNAMIC_ATT_PROTOCOL_CMD_RAMP        (0x000F)
+#define DYNAMIC_ATT_PROTOCOL_CMD_BEGIN       (0x0010)
+#define DYNAMIC_ATT_PROTOCOL_CMD_COMMIT      (0x0011)
+#define DYNAMIC_ATT_PROTOCOL_CMD_ACK         (0x0012)
+
+/**
+ * Largest packet a client may send, header included.
+ * Writes to a fifo of up to PIPE_BUF bytes are atomic, so keeping packets within this size
+ * ensures packets from several clients never interleave.
+ */
+#define DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE (4096)
 
 /**
  * Command format:
@@ -21,13 +46,27 @@ extern "C" {
  *   Bytes ..XX : Command payload data size in bytes excluding header
  *
  * Payload:
- *   CMD_RESET: None
+ *   See the command structures below
  */
 typedef struct {
     unsigned short command;
     unsigned short payload_size;
 } __attribute__((packed)) ch_dynamic_att_com_protocol_header_t;
 
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_RESET
+ *
+ * Reset all attenuation settings to the default. The device number is optional: a reset carrying
+ * it is held in the caller's transaction like the caller's other commands, a reset without it is
+ * applied as it is received.
+ *
+ * Data size: 0 or 2 bytes
+ *   Bytes XX : Callers device number
+ */
+typedef struct {
+    unsigned short device;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_reset_t;
+
 /**
  * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL
  *
@@ -60,15 +99,289 @@ typedef struct {
     double         attenuation_tx;
 } __attribute__((packed)) ch_dynamic_att_com_protocol_set_att_one_t;
 
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX and DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_RX
+ *
+ * Set attenuation between caller and a consecutive range of peer devices, in one direction.
+ * CMD_SET_ATT_TX sets the Tx attenuation for packets sent from caller to the peers (a Tx row).
+ * CMD_SET_ATT_RX sets the Rx attenuation for packets sent from the peers to caller (an Rx row).
+ * The entry for the caller itself, if inside the range, is ignored.
+ *
+ * Data size: 6 + 8*count bytes
+ *   Bytes XX........ : Callers device number
+ *   Bytes ..XX...... : First peer device number
+ *   Bytes ....XX.... : Number of peers (count)
+ *   Bytes ......XX.. : count attenuations of 8 bytes, for peer device first_peer + i
+ */
+typedef struct {
+    unsigned short device;
+    unsigned short first_peer_device;
+    unsigned short count;
+    double         attenuation[];
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_att_vector_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_LST
+ *
+ * Set unique Rx and Tx attenuation between caller and a list of peer devices
+ *
+ * Data size: 4 + 18*count bytes
+ *   Bytes XX.. : Callers device number
+ *   Bytes ..XX : Number of list entries (count)
+ *   Followed by count entries of 18 bytes:
+ *     Bytes XX................ : Peer device number
+ *     Bytes ..XXXXXXXX........ : Rx attenuation for packets sent from peer to caller
+ *     Bytes ..........XXXXXXXX : Tx attenuation for packets sent from caller to peer
+ */
+typedef struct {
+    unsigned short peer_device;
+    double         attenuation_rx;
+    double         attenuation_tx;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_link_t;
+
+typedef struct {
+    unsigned short                     device;
+    unsigned short                     count;
+    ch_dynamic_att_com_protocol_link_t links[];
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_att_list_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME
+ *
+ * Apply another command at a given simulation time, instead of as soon as it is received.
+ * Commands scheduled for the same time are applied in the order they were received.
+ * The wrapped command cannot itself be a CMD_AT_TIME.
+ *
+ * Data size: 12 + wrapped command payload size bytes
+ *   Bytes XXXXXXXX.... : Simulation time in microseconds at which to apply the command
+ *   Bytes ........XX.. : Wrapped command header
+ *   Bytes ..........XX : Wrapped command payload
+ */
+typedef struct {
+    uint64_t      apply_time;
+    unsigned char packet[];
+} __attribute__((packed)) ch_dynamic_att_com_protocol_at_time_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP
+ *
+ * Move caller to a group. Only valid when the channel runs with groups.
+ *
+ * Data size: 4 bytes
+ *   Bytes XX.. : Callers device number
+ *   Bytes ..XX : Group number
+ */
+typedef struct {
+    unsigned short device;
+    unsigned short group;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_group_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP_ATT
+ *
+ * Set Rx and Tx attenuation between the devices of two groups. Only valid when the channel runs
+ * with groups. When group and peer group are the same, the Tx attenuation applies between all
+ * devices of that group. The device number is optional, as for CMD_RESET.
+ *
+ * Data size: 20 or 22 bytes
+ *   Bytes XX.................... : Group number
+ *   Bytes ..XX.................. : Peer group number
+ *   Bytes ....XXXXXXXX.......... : Rx attenuation for packets sent from peer group to group
+ *   Bytes ............XXXXXXXX.. : Tx attenuation for packets sent from group to peer group
+ *   Bytes ....................XX : Callers device number
+ */
+typedef struct {
+    unsigned short group;
+    unsigned short peer_group;
+    double         attenuation_rx;
+    double         attenuation_tx;
+    unsigned short device;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_group_att_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT
+ *
+ * Save the attenuation of all links to a snapshot file, which can be loaded at startup with the
+ * -snapshot argument. The format is described in channel_dynamic_att_snapshot_format.h.
+ *
+ * Data size: length of file name + 1 bytes
+ *   Bytes XX.. : File name, relative to the working directory of the channel, terminated by a zero byte
+ *
+ * The payload is the file name itself, accessed by casting the payload to a char pointer.
+ */
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_BIN
+ *
+ * Set unique Rx and Tx attenuation between caller and one other peer device, for a consecutive
+ * range of frequency bins only. The channel splits the 2.4 GHz band (2400 to 2480 MHz) into
+ * -freq_bins equally wide bins, and looks up the bin of the transmitter's center frequency.
+ * The other commands set all bins of a link.
+ *
+ * Data size: 24 bytes
+ *   Bytes XX...................... : Callers device number
+ *   Bytes ..XX.................... : Peer device number
+ *   Bytes ....XX.................. : First frequency bin
+ *   Bytes ......XX................ : Number of frequency bins
+ *   Bytes ........XXXXXXXX........ : Rx attenuation for packets sent from peer to caller
+ *   Bytes ................XXXXXXXX : Tx attenuation for packets sent from caller to peer
+ */
+typedef struct {
+    unsigned short device;
+    unsigned short peer_device;
+    unsigned short first_bin;
+    unsigned short count;
+    double         attenuation_rx;
+    double         attenuation_tx;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_att_bin_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ALL
+ *
+ * Set the same fading standard deviation between caller and all other devices, in both
+ * directions. Only valid when the channel runs with fading (-fading).
+ *
+ * Data size: 10 bytes
+ *   Bytes XX........ : Callers device number
+ *   Bytes ..XXXXXXXX : Fading standard deviation in dB for all connections
+ */
+typedef struct {
+    unsigned short device;
+    double         sigma;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_fading_all_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ONE
+ *
+ * Set unique Rx and Tx fading standard deviation between caller and one other peer device.
+ * Only valid when the channel runs with fading (-fading).
+ *
+ * Data size: 20 bytes
+ *   Bytes XX.................. : Callers device number
+ *   Bytes ..XX................ : Peer device number
+ *   Bytes ....XXXXXXXX........ : Standard deviation in dB for packets sent from peer to caller
+ *   Bytes ............XXXXXXXX : Standard deviation in dB for packets sent from caller to peer
+ */
+typedef struct {
+    unsigned short device;
+    unsigned short peer_device;
+    double         sigma_rx;
+    double         sigma_tx;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_fading_one_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_POS
+ *
+ * Move caller to a position. Only valid when the channel runs with a path loss model
+ * (-pathloss). The attenuation of all links between caller and other devices with a position
+ * is then computed from their distance.
+ *
+ * Data size: 26 bytes
+ *   Bytes XX........................ : Callers device number
+ *   Bytes ..XXXXXXXX................ : x in meters
+ *   Bytes ..........XXXXXXXX........ : y in meters
+ *   Bytes ..................XXXXXXXX : z in meters
+ */
+typedef struct {
+    unsigned short device;
+    double         position[3];
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_position_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_SET_OFFSET
+ *
+ * Set an attenuation added to the computed attenuation of all links to and from caller, e.g.
+ * for antenna gain or body loss. Only valid when the channel runs with a path loss model.
+ *
+ * Data size: 10 bytes
+ *   Bytes XX........ : Callers device number
+ *   Bytes ..XXXXXXXX : Attenuation offset in dB
+ */
+typedef struct {
+    unsigned short device;
+    double         offset;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_set_offset_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_RAMP
+ *
+ * Change the attenuation between caller and one other peer device linearly over time, in both
+ * directions. The link has the start attenuation until the start time and the end attenuation
+ * from the end time on. Any later command setting the attenuation of the link stops the ramp.
+ *
+ * Data size: 36 bytes
+ *   Bytes XX.................................. : Callers device number
+ *   Bytes ..XX................................ : Peer device number
+ *   Bytes ....XXXXXXXX........................ : Attenuation at the start time
+ *   Bytes ............XXXXXXXX................ : Attenuation at the end time
+ *   Bytes ....................XXXXXXXX........ : Simulation time in microseconds at which the ramp starts
+ *   Bytes ............................XXXXXXXX : Simulation time in microseconds at which the ramp ends
+ */
+typedef struct {
+    unsigned short device;
+    unsigned short peer_device;
+    double         start_attenuation;
+    double         end_attenuation;
+    uint64_t       start_time;
+    uint64_t       end_time;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_ramp_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_BEGIN and DYNAMIC_ATT_PROTOCOL_CMD_COMMIT
+ *
+ * Group commands of caller into a transaction. After CMD_BEGIN the channel holds every command
+ * carrying the caller's device number, and applies them together, in order, when CMD_COMMIT is
+ * received, so no channel evaluation sees only part of them. CMD_RESET and CMD_SET_GRP_ATT are
+ * held when they carry the caller's device number. CMD_SNAPSHOT, and CMD_RESET and
+ * CMD_SET_GRP_ATT without a device number, are applied as they are received.
+ *
+ * Data size: 2 bytes
+ *   Bytes XX : Callers device number
+ */
+typedef struct {
+    unsigned short device;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_txn_t;
+
+/**
+ * @brief DYNAMIC_ATT_PROTOCOL_CMD_ACK
+ *
+ * Ask the channel to acknowledge that every command caller sent before this one has been applied.
+ * The channel applies the commands of one client in order, so when it applies CMD_ACK it writes
+ * the sequence number and the simulation time to the caller's entry of the ack page (see
+ * channel_dynamic_att_ack_format.h). Wrapped in CMD_AT_TIME it is acknowledged after the
+ * commands scheduled for the same time, and inside a transaction when it is committed.
+ *
+ * Data size: 6 bytes
+ *   Bytes XX.... : Callers device number
+ *   Bytes ..XXXX : Sequence number, increasing with every CMD_ACK of the caller
+ */
+typedef struct {
+    unsigned short device;
+    uint32_t       sequence;
+} __attribute__((packed)) ch_dynamic_att_com_protocol_ack_t;
+
 /**
  * Combined packet structure
+ *
+ * Variable sized payloads (CMD_SET_ATT_TX, CMD_SET_ATT_RX, CMD_SET_ATT_LST, CMD_AT_TIME and CMD_SNAPSHOT) follow the header
+ * directly and are accessed by casting the payload to their type.
 */
 typedef struct {
     ch_dynamic_att_com_protocol_header_t header;
     union
     {
+        ch_dynamic_att_com_protocol_reset_t reset_payload;
         ch_dynamic_att_com_protocol_set_att_all_t set_att_all_payload;
         ch_dynamic_att_com_protocol_set_att_one_t set_att_one_payload;
+        ch_dynamic_att_com_protocol_set_group_t set_group_payload;
+        ch_dynamic_att_com_protocol_set_group_att_t set_group_att_payload;
+        ch_dynamic_att_com_protocol_set_att_bin_t set_att_bin_payload;
+        ch_dynamic_att_com_protocol_set_fading_all_t set_fading_all_payload;
+        ch_dynamic_att_com_protocol_set_fading_one_t set_fading_one_payload;
+        ch_dynamic_att_com_protocol_set_position_t set_position_payload;
+        ch_dynamic_att_com_protocol_set_offset_t set_offset_payload;
+        ch_dynamic_att_com_protocol_ramp_t ramp_payload;
+        ch_dynamic_att_com_protocol_txn_t txn_payload;
+        ch_dynamic_att_com_protocol_ack_t ack_payload;
     } payload;
 } __attribute__((packed)) ch_dynamic_att_com_protocol_packet_t;
 
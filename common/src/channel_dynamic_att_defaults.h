@@ -12,4 +12,16 @@
 
 #define DYNAMIC_ATT_DEFAULT_FIFO_NAME "dynamic_att.dtc"
 
+/* Above this number of devices the automatic storage mode only stores non default links */
+#define DYNAMIC_ATT_SPARSE_THRESHOLD (2048)
+
+/* Most groups in group mode, so the 8 KiB group matrix takes at most a quarter of a 32 KiB L1 data cache */
+#define DYNAMIC_ATT_MAX_GROUPS (32)
+
+/* Most frequency bins, one per MHz of the 2.4 GHz band */
+#define DYNAMIC_ATT_MAX_FREQ_BINS (80)
+
+/* Largest matrix with frequency bins allocated without an explicit -st=dense, in bytes */
+#define DYNAMIC_ATT_FREQ_BINS_MAX_AUTO_SIZE (1024ULL*1024*1024)
+
 #endif /* _CHANNEL_DYNAMIC_ATT_DEFAULTS_H */
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_JOURNAL_FORMAT_H
+#define _CHANNEL_DYNAMIC_ATT_JOURNAL_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Command journal file format
+ *
+ * All fields are in host byte order. The file consists of:
+ *   Header:  ch_dynamic_att_journal_header_t
+ *   Records: one per applied command, in the order they were applied, until the end of the file
+ *
+ * A record has the same layout as a CMD_AT_TIME payload:
+ *   Bytes XXXXXXXX.... : Simulation time in microseconds of the channel evaluation which applied the command
+ *   Bytes ........XX.. : Command header
+ *   Bytes ..........XX : Command payload
+ *
+ * Scheduled commands are recorded when they are applied, as the command they wrap.
+ */
+
+#define DYNAMIC_ATT_JOURNAL_MAGIC   (0x4A544144) /* "DATJ" */
+#define DYNAMIC_ATT_JOURNAL_VERSION (1)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_devices;
+    uint32_t reserved;
+} ch_dynamic_att_journal_header_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_JOURNAL_FORMAT_H */
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_SHM_RING_H
+#define _CHANNEL_DYNAMIC_ATT_SHM_RING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Shared memory command ring
+ *
+ * An alternative to the fifo for sending commands from clients to the channel. The channel
+ * creates a file in the simulation com folder, named as the fifo with DYNAMIC_ATT_SHM_RING_SUFFIX
+ * appended, and clients map it. The ring is lock-free with many producers (clients) and one
+ * consumer (the channel).
+ *
+ * A client only uses a ring whose magic is set and whose owner_pid is a running process, so a file
+ * left behind by a channel which crashed is not mistaken for the ring of the next one. The channel
+ * clears magic before it removes a ring file, its own in channel_delete() and one left over from an
+ * earlier run in channel_init().
+ *
+ * The data area is a sequence of records, each starting at an 8 byte aligned offset with a
+ * ch_dynamic_att_shm_ring_record_t followed by one or more whole command packets. A record never
+ * wraps around the end of the data area; when it would, the producer first fills the rest of the
+ * area with a padding record.
+ *
+ * Producer:
+ *   1. Reserve space by advancing write_reserve with compare-and-swap, after checking that
+ *      write_reserve - read_pos leaves room for the record (and padding).
+ *   2. Write the padding record length, if any, and the packets.
+ *   3. Publish the record by storing its length with release semantics.
+ *
+ * Consumer:
+ *   1. Load the record length at read_pos with acquire semantics. Zero means no data yet.
+ *   2. Take the packets, clear the record to zero, and advance read_pos with release semantics.
+ */
+
+#define DYNAMIC_ATT_SHM_RING_MAGIC     (0x52544144) /* "DATR" */
+#define DYNAMIC_ATT_SHM_RING_SIZE      (256*1024)   /* Bytes in the data area, a power of two */
+#define DYNAMIC_ATT_SHM_RING_SUFFIX    ".shm"
+#define DYNAMIC_ATT_SHM_RING_PAD_FLAG  (0x80000000U)
+
+typedef struct {
+    uint32_t length;      /* Record length including this header and alignment, 0 until published */
+    uint32_t packet_size; /* Size of the command packets following this header */
+} ch_dynamic_att_shm_ring_record_t;
+
+typedef struct {
+    uint32_t      magic;     /* Written last by the channel, once the ring is ready */
+    uint32_t      size;
+    uint32_t      owner_pid; /* Process id of the channel */
+    uint64_t      write_reserve __attribute__((aligned(64)));
+    uint64_t      read_pos      __attribute__((aligned(64)));
+    unsigned char data[]        __attribute__((aligned(64)));
+} ch_dynamic_att_shm_ring_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_SHM_RING_H */
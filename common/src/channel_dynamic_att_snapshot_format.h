@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_SNAPSHOT_FORMAT_H
+#define _CHANNEL_DYNAMIC_ATT_SNAPSHOT_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Attenuation snapshot file format
+ *
+ * All fields are in host byte order. The file consists of:
+ *   Header:  ch_dynamic_att_snapshot_header_t
+ *   Matrix:  num_devices*num_devices doubles, Rx-major like the channel's own matrix,
+ *            i.e. the attenuation for packets sent from tx to rx is at index rx*num_devices + tx
+ *
+ * The entries for a device to itself are ignored. The default attenuation is the one the channel
+ * which saved the snapshot was started with, for reference only.
+ */
+
+#define DYNAMIC_ATT_SNAPSHOT_MAGIC   (0x4D544144) /* "DATM" */
+#define DYNAMIC_ATT_SNAPSHOT_VERSION (1)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_devices;
+    uint32_t reserved;
+    double   default_attenuation;
+} ch_dynamic_att_snapshot_header_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_SNAPSHOT_FORMAT_H */
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_STATS_FORMAT_H
+#define _CHANNEL_DYNAMIC_ATT_STATS_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Statistics page
+ *
+ * The channel keeps its counters in a file in the simulation com folder, named as the fifo with
+ * DYNAMIC_ATT_STATS_SUFFIX appended, and updates them in place through a shared mapping. Other
+ * processes can map or read the file at any time to follow a running simulation. The channel
+ * creates a new file in channel_init() and deletes it in channel_delete(), after printing a summary.
+ *
+ * Every counter is a plain 64 bit store done by the channel only. A reader sees each counter
+ * either before or after an update, but counters are not updated together, so values read at
+ * the same time can be from slightly different moments.
+ *
+ * Lateness is the simulation time from a scheduled command's apply time until it was applied, for
+ * commands sent with CMD_AT_TIME only. Plain commands carry no time and are not counted: the
+ * channel cannot know when they were sent. A command which arrives after its apply time is applied
+ * in the next evaluation, so sending with the _at functions of the client library and the
+ * client's current simulation time gives the send to apply latency of those commands. Bucket 0
+ * counts a lateness of 0, bucket i counts [2^(i-1), 2^i) us, and the last bucket counts everything
+ * above.
+ */
+
+#define DYNAMIC_ATT_STATS_MAGIC           (0x53544144) /* "DATS" */
+#define DYNAMIC_ATT_STATS_VERSION         (1)
+#define DYNAMIC_ATT_STATS_SUFFIX          ".stats"
+#define DYNAMIC_ATT_STATS_COMMANDS        (32) /* Commands with a higher number are counted in the last entry */
+#define DYNAMIC_ATT_STATS_LATENESS_BUCKETS (32)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_devices;
+    uint32_t reserved;
+    uint64_t now;               /* Simulation time of the last channel evaluation */
+    uint64_t calc_calls;        /* Calls to channel_calc() */
+    uint64_t polls;             /* Checks for new data on the fifo or shared memory ring */
+    uint64_t empty_polls;       /* Checks which found no new data */
+    uint64_t bytes_read;        /* Bytes received */
+    uint64_t partial_reads;     /* Checks which ended with part of a packet still to come */
+    uint64_t malformed;         /* Times the command stream went out of frame */
+    uint64_t skipped_bytes;     /* Bytes skipped while out of frame */
+    uint64_t commands[DYNAMIC_ATT_STATS_COMMANDS]; /* Commands applied, by command number */
+    uint64_t lateness[DYNAMIC_ATT_STATS_LATENESS_BUCKETS]; /* Scheduled commands, by lateness */
+} ch_dynamic_att_stats_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_STATS_FORMAT_H */
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_TIMELINE_FORMAT_H
+#define _CHANNEL_DYNAMIC_ATT_TIMELINE_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Attenuation timeline file format
+ *
+ * All fields are in host byte order. The file consists of:
+ *   Header:  ch_dynamic_att_timeline_header_t
+ *   Links:   num_devices*num_devices ch_dynamic_att_timeline_link_t, Rx-major,
+ *            i.e. the entry for packets sent from tx to rx is at index rx*num_devices + tx
+ *   Points:  num_points ch_dynamic_att_timeline_point_t
+ *
+ * Each link with a timeline refers to <count> consecutive points starting at <first_point>,
+ * sorted by increasing time. Between two points the attenuation is interpolated linearly,
+ * before the first point it is the first value and after the last point it is the last value.
+ * Links with count 0 have no timeline and use the attenuation set by the clients.
+ */
+
+#define DYNAMIC_ATT_TIMELINE_MAGIC   (0x4C544144) /* "DATL" */
+#define DYNAMIC_ATT_TIMELINE_VERSION (1)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_devices;
+    uint32_t reserved;
+    uint64_t num_points;
+} ch_dynamic_att_timeline_header_t;
+
+typedef struct {
+    uint64_t first_point;
+    uint32_t count;
+    uint32_t reserved;
+} ch_dynamic_att_timeline_link_t;
+
+typedef struct {
+    uint64_t time;        /* Simulation time in microseconds */
+    double   attenuation; /* Attenuation in dB at that time */
+} ch_dynamic_att_timeline_point_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_TIMELINE_FORMAT_H */
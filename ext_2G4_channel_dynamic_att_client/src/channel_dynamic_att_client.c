@@ -3,28 +3,191 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+/*
+** Include this file before including system headers.  By default, with
+** C99 support from the compiler, it requests POSIX 2008 support.  With
+** C89 support only, it requests POSIX 1997 support.  Override the
+** default behaviour by setting either _XOPEN_SOURCE or _POSIX_C_SOURCE.
+*/
+/* _XOPEN_SOURCE 700 is loosely equivalent to _POSIX_C_SOURCE 200809L */
+/* _XOPEN_SOURCE 600 is loosely equivalent to _POSIX_C_SOURCE 200112L */
+/* _XOPEN_SOURCE 500 is loosely equivalent to _POSIX_C_SOURCE 199506L */
+#if !defined(_XOPEN_SOURCE) && !defined(_POSIX_C_SOURCE)
+#if defined(__cplusplus)
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#elif __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#else
+#define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
+#endif /* __STDC_VERSION__ */
+#endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include "bs_oswrap.h"
 #include "bs_types.h"
 #include "bs_tracing.h"
 #include "bs_pc_base.h"
 #include "channel_dynamic_att_client.h"
+#include "channel_dynamic_att_client_queue.h"
+#include "channel_dynamic_att_ack_format.h"
 #include "channel_dynamic_att_com_protocol.h"
 #include "channel_dynamic_att_defaults.h"
+#include "channel_dynamic_att_shm_ring.h"
 
 extern char *pb_com_path;
 extern uint global_device_nbr;
 
+/* Buffered mode: a command waiting for the next flush */
+typedef struct {
+    size_t         offset;      /* Of the packet in the buffer */
+    unsigned short size;
+    unsigned short command;
+    bool           superseded;  /* A later command makes this one redundant, it is not sent */
+} ch_dynamic_att_client_pending_t;
+
 static struct {
-    char *fifo_full_path;
-    int   fifo_write_handle;
-} channel_dynamic_att_client_prv = {0};
+    char                      *fifo_full_path;
+    int                        fifo_write_handle;
+    ch_dynamic_att_shm_ring_t *ring;
+    size_t                     ring_map_size;
+
+    char                        *ack_full_path;
+    ch_dynamic_att_ack_header_t *ack_page;
+    size_t                       ack_map_size;
+    uint32_t                     ack_sequence;  /* Of the last acknowledgement requested */
+
+    bool                             buffered;
+    size_t                           flush_threshold;
+    unsigned char                   *buffer;
+    size_t                           buffer_used;
+    size_t                           buffer_capacity;
+    size_t                           pending_bytes;
+    ch_dynamic_att_client_pending_t *pending;
+    size_t                           pending_count;
+    size_t                           pending_capacity;
+    uint                            *pending_one_by_peer; /* Pending SET_ATT_ONE or RAMP index + 1 per peer, 0 if none */
+    size_t                           pending_one_by_peer_size;
+    size_t                           pending_group;       /* Pending SET_GRP index + 1, 0 if none */
+    size_t                           pending_position;    /* Pending SET_POS index + 1, 0 if none */
+    size_t                           pending_first;       /* Pending commands before this one are already sent */
+    size_t                           pending_committed;   /* Pending commands before this one precede a commit, ack or snapshot and are kept */
+    bool                             transaction_open;    /* A CMD_BEGIN was buffered without its CMD_COMMIT */
+
+    bool                                      async;
+    bool                                      async_shm;    /* The writer thread uses the shared memory ring */
+    channel_dynamic_att_client_queue_policy_t policy;
+    size_t                                    dropped;
+    pthread_t                                 writer;
+    pthread_mutex_t                           writer_mutex;
+    pthread_cond_t                            writer_cond;
+    bool                                      writer_sleeping;
+    bool                                      writer_stop;
+} channel_dynamic_att_client_prv = {
+    .fifo_write_handle = -1
+};
+
+static void channel_dynamic_att_client_sleep_us(long us)
+{
+    struct timespec delay = {
+        .tv_sec  = us / 1000000,
+        .tv_nsec = (us % 1000000)*1000
+    };
+
+    nanosleep(&delay, NULL);
+}
+
+/*
+ * Publish one packet in the shared memory ring, waiting for the channel to make room if it is full.
+ * See channel_dynamic_att_shm_ring.h for the protocol.
+ */
+static bool channel_dynamic_att_client_ring_push(const void *data, size_t data_size)
+{
+    ch_dynamic_att_shm_ring_t *ring = channel_dynamic_att_client_prv.ring;
+    uint32_t length = (sizeof(ch_dynamic_att_shm_ring_record_t) + data_size + 7U) & ~7U;
+    ch_dynamic_att_shm_ring_record_t *record;
+    uint64_t pos;
+    uint64_t pad;
+
+    for (;;) {
+        pos = __atomic_load_n(&ring->write_reserve, __ATOMIC_RELAXED);
+        pad = ((pos & (ring->size - 1U)) + length > ring->size) ? ring->size - (pos & (ring->size - 1U)) : 0U;
+        if (pos + pad + length - __atomic_load_n(&ring->read_pos, __ATOMIC_ACQUIRE) > ring->size) {
+            /* Full, like a blocking fifo write wait for the channel to catch up */
+            channel_dynamic_att_client_sleep_us(10);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&ring->write_reserve, &pos, pos + pad + length, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (pad) {
+        record = (ch_dynamic_att_shm_ring_record_t *)(ring->data + (pos & (ring->size - 1U)));
+        __atomic_store_n(&record->length, (uint32_t)pad | DYNAMIC_ATT_SHM_RING_PAD_FLAG, __ATOMIC_RELEASE);
+    }
+    record = (ch_dynamic_att_shm_ring_record_t *)(ring->data + ((pos + pad) & (ring->size - 1U)));
+    record->packet_size = data_size;
+    memcpy(record + 1, data, data_size);
+    __atomic_store_n(&record->length, length, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static bool channel_dynamic_att_client_buffer_packet(const void *packet, size_t packet_size);
+
+static void channel_dynamic_att_client_wake_writer(void)
+{
+    if (__atomic_load_n(&channel_dynamic_att_client_prv.writer_sleeping, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&channel_dynamic_att_client_prv.writer_mutex);
+        pthread_cond_signal(&channel_dynamic_att_client_prv.writer_cond);
+        pthread_mutex_unlock(&channel_dynamic_att_client_prv.writer_mutex);
+    }
+}
+
+/*
+ * Queue one packet for the writer thread, waiting or dropping the oldest packets if the queue is full
+ */
+static void channel_dynamic_att_client_async_push(const void *data, size_t data_size)
+{
+    while (!channel_dynamic_att_client_queue_try_push(data, data_size)) {
+        if (channel_dynamic_att_client_prv.policy == DYNAMIC_ATT_CLIENT_QUEUE_DROP_OLDEST &&
+            channel_dynamic_att_client_queue_drop_oldest()) {
+            channel_dynamic_att_client_prv.dropped++;
+        } else {
+            channel_dynamic_att_client_wake_writer();
+            channel_dynamic_att_client_sleep_us(10);
+        }
+    }
+}
 
 static bool channel_dynamic_att_client_write(void *data, size_t data_size)
 {
     ssize_t bytes_written;
 
+    if (channel_dynamic_att_client_prv.async) {
+        if (channel_dynamic_att_client_prv.policy == DYNAMIC_ATT_CLIENT_QUEUE_COALESCE) {
+            /* Keep order: once commands are held back, later ones are held back behind them */
+            if (channel_dynamic_att_client_prv.pending_count > channel_dynamic_att_client_prv.pending_first ||
+                !channel_dynamic_att_client_queue_try_push(data, data_size)) {
+                channel_dynamic_att_client_buffer_packet(data, data_size);
+                return channel_dynamic_att_client_flush();
+            }
+        } else {
+            channel_dynamic_att_client_async_push(data, data_size);
+        }
+        channel_dynamic_att_client_wake_writer();
+        return true;
+    }
+    if (channel_dynamic_att_client_prv.ring) {
+        return channel_dynamic_att_client_ring_push(data, data_size);
+    }
     if (channel_dynamic_att_client_prv.fifo_write_handle < 0) {
         return false;
     }
@@ -33,43 +196,578 @@ static bool channel_dynamic_att_client_write(void *data, size_t data_size)
     if (bytes_written == -1) {
         bs_trace_error("Failed writing fifo");
     }
-    return bytes_written == data_size;
+    return bytes_written == (ssize_t)data_size;
+}
+
+/*
+ * Write the non superseded pending commands, in as few writes as possible.
+ * Each write is kept within DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE so it is atomic on the fifo.
+ */
+static bool channel_dynamic_att_client_write_pending(void)
+{
+    struct iovec iov[DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE / sizeof(ch_dynamic_att_com_protocol_header_t)];
+    size_t iov_count = 0U;
+    size_t iov_bytes = 0U;
+    bool result = true;
+
+    if (channel_dynamic_att_client_prv.async) {
+        for (size_t i = channel_dynamic_att_client_prv.pending_first; i < channel_dynamic_att_client_prv.pending_count; i++) {
+            const ch_dynamic_att_client_pending_t *pending = &channel_dynamic_att_client_prv.pending[i];
+            const unsigned char *packet = channel_dynamic_att_client_prv.buffer + pending->offset;
+
+            if (pending->superseded) {
+                continue;
+            }
+            if (channel_dynamic_att_client_prv.policy == DYNAMIC_ATT_CLIENT_QUEUE_COALESCE) {
+                /* Queue full: keep the rest pending, where later commands can still replace them */
+                if (!channel_dynamic_att_client_queue_try_push(packet, pending->size)) {
+                    channel_dynamic_att_client_prv.pending_first = i;
+                    channel_dynamic_att_client_wake_writer();
+                    return true;
+                }
+            } else {
+                channel_dynamic_att_client_async_push(packet, pending->size);
+            }
+            channel_dynamic_att_client_prv.pending_bytes -= pending->size;
+        }
+        channel_dynamic_att_client_prv.pending_first = channel_dynamic_att_client_prv.pending_count;
+        channel_dynamic_att_client_wake_writer();
+        return true;
+    }
+
+    for (size_t i = 0U; i <= channel_dynamic_att_client_prv.pending_count; i++) {
+        const ch_dynamic_att_client_pending_t *pending = &channel_dynamic_att_client_prv.pending[i];
+        bool last = (i == channel_dynamic_att_client_prv.pending_count);
+
+        if (!last && pending->superseded) {
+            continue;
+        }
+        if (iov_count && (last || iov_bytes + pending->size > DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE)) {
+            if (channel_dynamic_att_client_prv.ring) {
+                for (size_t j = 0U; j < iov_count; j++) {
+                    result &= channel_dynamic_att_client_ring_push(iov[j].iov_base, iov[j].iov_len);
+                }
+            } else if (channel_dynamic_att_client_prv.fifo_write_handle >= 0) {
+                ssize_t bytes_written = writev(channel_dynamic_att_client_prv.fifo_write_handle, iov, iov_count);
+
+                if (bytes_written == -1) {
+                    bs_trace_error("Failed writing fifo");
+                }
+                result &= (bytes_written == (ssize_t)iov_bytes);
+            } else {
+                result = false;
+            }
+            iov_count = 0U;
+            iov_bytes = 0U;
+        }
+        if (!last) {
+            iov[iov_count].iov_base = channel_dynamic_att_client_prv.buffer + pending->offset;
+            iov[iov_count].iov_len = pending->size;
+            iov_count++;
+            iov_bytes += pending->size;
+        }
+    }
+    channel_dynamic_att_client_prv.pending_first = channel_dynamic_att_client_prv.pending_count;
+    return result;
+}
+
+static void channel_dynamic_att_client_clear_pending(void)
+{
+    for (size_t i = 0U; i < channel_dynamic_att_client_prv.pending_count; i++) {
+        const ch_dynamic_att_client_pending_t *pending = &channel_dynamic_att_client_prv.pending[i];
+
+        const ch_dynamic_att_com_protocol_packet_t *packet = (const ch_dynamic_att_com_protocol_packet_t *)(channel_dynamic_att_client_prv.buffer + pending->offset);
+
+        if (pending->command == DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE) {
+            channel_dynamic_att_client_prv.pending_one_by_peer[packet->payload.set_att_one_payload.peer_device] = 0U;
+        } else if (pending->command == DYNAMIC_ATT_PROTOCOL_CMD_RAMP) {
+            channel_dynamic_att_client_prv.pending_one_by_peer[packet->payload.ramp_payload.peer_device] = 0U;
+        }
+    }
+    channel_dynamic_att_client_prv.pending_group = 0U;
+    channel_dynamic_att_client_prv.pending_position = 0U;
+    channel_dynamic_att_client_prv.pending_first = 0U;
+    channel_dynamic_att_client_prv.pending_committed = 0U;
+    channel_dynamic_att_client_prv.pending_count = 0U;
+    channel_dynamic_att_client_prv.buffer_used = 0U;
+    channel_dynamic_att_client_prv.pending_bytes = 0U;
+}
+
+static void channel_dynamic_att_client_supersede(size_t index)
+{
+    ch_dynamic_att_client_pending_t *pending = &channel_dynamic_att_client_prv.pending[index];
+
+    /*
+     * Commands already handed to the writer thread cannot be taken back, and commands of a
+     * committed transaction must reach the channel together
+     */
+    if (index >= channel_dynamic_att_client_prv.pending_first && index >= channel_dynamic_att_client_prv.pending_committed &&
+        !pending->superseded) {
+        pending->superseded = true;
+        channel_dynamic_att_client_prv.pending_bytes -= pending->size;
+    }
+}
+
+/*
+ * True for commands which only set the attenuation of links of the sending device
+ */
+static bool channel_dynamic_att_client_sets_links(unsigned short command)
+{
+    switch (command) {
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_RX:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_LST:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_BIN:
+        case DYNAMIC_ATT_PROTOCOL_CMD_RAMP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * Add a command to the pending buffer, dropping earlier pending commands it makes redundant:
+ *   CMD_RESET drops all pending commands after the last CMD_COMMIT, CMD_ACK or CMD_SNAPSHOT, except
+ *   scheduled ones.
+ *   CMD_SET_ATT_ALL drops the same pending commands, but only those setting the attenuation of links.
+ *   CMD_SET_ATT_ONE and CMD_RAMP drop a pending CMD_SET_ATT_ONE or CMD_RAMP for the same peer, as
+ *   both set the whole link.
+ *   CMD_SET_GRP drops a pending CMD_SET_GRP.
+ *   CMD_SET_POS drops a pending CMD_SET_POS.
+ * Commands before a CMD_COMMIT are never dropped, as that could make part of the transaction
+ * visible on its own. Neither is transaction framing. Commands before a
+ * CMD_ACK, and the CMD_ACK itself, are never dropped either, as the acknowledgement promises they
+ * were applied. Neither are commands before a CMD_SNAPSHOT, and the CMD_SNAPSHOT itself, as the
+ * snapshot saves the attenuation they set, and writing it is a side effect no later command undoes.
+ */
+static bool channel_dynamic_att_client_buffer_packet(const void *packet, size_t packet_size)
+{
+    const ch_dynamic_att_com_protocol_packet_t *new_packet = packet;
+    ch_dynamic_att_client_pending_t *pending;
+    unsigned short peer_device;
+
+    switch (new_packet->header.command) {
+        case DYNAMIC_ATT_PROTOCOL_CMD_RESET:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL:
+            for (size_t i = 0U; i < channel_dynamic_att_client_prv.pending_count; i++) {
+                unsigned short command = channel_dynamic_att_client_prv.pending[i].command;
+
+                if (command != DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME && command != DYNAMIC_ATT_PROTOCOL_CMD_BEGIN &&
+                    command != DYNAMIC_ATT_PROTOCOL_CMD_COMMIT &&
+                    (new_packet->header.command == DYNAMIC_ATT_PROTOCOL_CMD_RESET ||
+                     channel_dynamic_att_client_sets_links(command))) {
+                    channel_dynamic_att_client_supersede(i);
+                }
+            }
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_BEGIN:
+            channel_dynamic_att_client_prv.transaction_open = true;
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_COMMIT:
+            channel_dynamic_att_client_prv.transaction_open = false;
+            channel_dynamic_att_client_prv.pending_committed = channel_dynamic_att_client_prv.pending_count;
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_ACK:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT:
+            /* Including the command itself */
+            channel_dynamic_att_client_prv.pending_committed = channel_dynamic_att_client_prv.pending_count + 1U;
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP:
+            if (channel_dynamic_att_client_prv.pending_group) {
+                channel_dynamic_att_client_supersede(channel_dynamic_att_client_prv.pending_group - 1U);
+            }
+            channel_dynamic_att_client_prv.pending_group = channel_dynamic_att_client_prv.pending_count + 1U;
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_POS:
+            if (channel_dynamic_att_client_prv.pending_position) {
+                channel_dynamic_att_client_supersede(channel_dynamic_att_client_prv.pending_position - 1U);
+            }
+            channel_dynamic_att_client_prv.pending_position = channel_dynamic_att_client_prv.pending_count + 1U;
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE:
+        case DYNAMIC_ATT_PROTOCOL_CMD_RAMP:
+            peer_device = new_packet->header.command == DYNAMIC_ATT_PROTOCOL_CMD_RAMP ? new_packet->payload.ramp_payload.peer_device :
+                                                                                         new_packet->payload.set_att_one_payload.peer_device;
+            if (peer_device >= channel_dynamic_att_client_prv.pending_one_by_peer_size) {
+                size_t old_size = channel_dynamic_att_client_prv.pending_one_by_peer_size;
+
+                channel_dynamic_att_client_prv.pending_one_by_peer_size = peer_device + 1U;
+                channel_dynamic_att_client_prv.pending_one_by_peer = bs_realloc(channel_dynamic_att_client_prv.pending_one_by_peer,
+                                                                               (peer_device + 1U)*sizeof(uint));
+                memset(channel_dynamic_att_client_prv.pending_one_by_peer + old_size, 0, (peer_device + 1U - old_size)*sizeof(uint));
+            }
+            if (channel_dynamic_att_client_prv.pending_one_by_peer[peer_device]) {
+                channel_dynamic_att_client_supersede(channel_dynamic_att_client_prv.pending_one_by_peer[peer_device] - 1U);
+            }
+            channel_dynamic_att_client_prv.pending_one_by_peer[peer_device] = channel_dynamic_att_client_prv.pending_count + 1U;
+            break;
+        default:
+            break;
+    }
+
+    if (channel_dynamic_att_client_prv.pending_count == channel_dynamic_att_client_prv.pending_capacity) {
+        channel_dynamic_att_client_prv.pending_capacity = channel_dynamic_att_client_prv.pending_capacity ? channel_dynamic_att_client_prv.pending_capacity*2U : 64U;
+        channel_dynamic_att_client_prv.pending = bs_realloc(channel_dynamic_att_client_prv.pending,
+                                                            channel_dynamic_att_client_prv.pending_capacity*sizeof(ch_dynamic_att_client_pending_t));
+    }
+    if (channel_dynamic_att_client_prv.buffer_used + packet_size > channel_dynamic_att_client_prv.buffer_capacity) {
+        channel_dynamic_att_client_prv.buffer_capacity = 2U*(channel_dynamic_att_client_prv.buffer_used + packet_size);
+        channel_dynamic_att_client_prv.buffer = bs_realloc(channel_dynamic_att_client_prv.buffer, channel_dynamic_att_client_prv.buffer_capacity);
+    }
+    if (!channel_dynamic_att_client_prv.pending || !channel_dynamic_att_client_prv.buffer) {
+        bs_trace_error("Error allocating memory for buffered commands");
+    }
+
+    pending = &channel_dynamic_att_client_prv.pending[channel_dynamic_att_client_prv.pending_count++];
+    pending->offset = channel_dynamic_att_client_prv.buffer_used;
+    pending->size = packet_size;
+    pending->command = new_packet->header.command;
+    pending->superseded = false;
+    memcpy(channel_dynamic_att_client_prv.buffer + pending->offset, packet, packet_size);
+    channel_dynamic_att_client_prv.buffer_used += packet_size;
+    channel_dynamic_att_client_prv.pending_bytes += packet_size;
+
+    if (channel_dynamic_att_client_prv.pending_bytes >= channel_dynamic_att_client_prv.flush_threshold) {
+        return channel_dynamic_att_client_flush();
+    }
+    return true;
 }
 
 static bool channel_dynamic_att_client_write_cmd(unsigned short command, void *payload, size_t payload_size)
 {
-    ch_dynamic_att_com_protocol_packet_t packet = {0};
+    unsigned char packet[DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE];
+    ch_dynamic_att_com_protocol_header_t header = {
+        .command      = command,
+        .payload_size = payload_size
+    };
 
-    packet.header.command = command;
-    packet.header.payload_size = payload_size;
+    if (sizeof(header) + payload_size > sizeof(packet)) {
+        bs_trace_error_line("Command %u payload of %zu bytes is too large\n", command, payload_size);
+    }
+    memcpy(packet, &header, sizeof(header));
     if (payload && payload_size) {
-        memcpy((void *)&packet.payload, payload, payload_size);
+        memcpy(packet + sizeof(header), payload, payload_size);
+    }
+
+    if (channel_dynamic_att_client_prv.buffered) {
+        return channel_dynamic_att_client_buffer_packet(packet, sizeof(header) + payload_size);
     }
 
     bs_trace_raw(8, "channel_dynamic_att_client_write_cmd: Sending cmd=%u, data size=%u\n", command, payload_size);
 
-    return channel_dynamic_att_client_write(&packet, sizeof(ch_dynamic_att_com_protocol_header_t) + packet.header.payload_size);
+    return channel_dynamic_att_client_write(packet, sizeof(header) + payload_size);
 }
 
-bool channel_dynamic_att_client_open(char *fifo_name)
+/*
+ * Wrap a command in CMD_AT_TIME so the channel applies it at apply_time
+ */
+static bool channel_dynamic_att_client_write_cmd_at(bs_time_t apply_time, unsigned short command, void *payload, size_t payload_size)
+{
+    unsigned char at_payload[DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE - sizeof(ch_dynamic_att_com_protocol_header_t)];
+    ch_dynamic_att_com_protocol_at_time_t at_time = {
+        .apply_time = apply_time
+    };
+    ch_dynamic_att_com_protocol_header_t header = {
+        .command      = command,
+        .payload_size = payload_size
+    };
+
+    if (sizeof(at_time) + sizeof(header) + payload_size > sizeof(at_payload)) {
+        bs_trace_error_line("Command %u payload of %zu bytes is too large to schedule\n", command, payload_size);
+    }
+    memcpy(at_payload, &at_time, sizeof(at_time));
+    memcpy(at_payload + sizeof(at_time), &header, sizeof(header));
+    if (payload && payload_size) {
+        memcpy(at_payload + sizeof(at_time) + sizeof(header), payload, payload_size);
+    }
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME, at_payload, sizeof(at_time) + sizeof(header) + payload_size);
+}
+
+/*
+ * Send attenuation for a range of peers in one direction, split in as few packets as possible
+ */
+static bool channel_dynamic_att_client_write_vector(unsigned short command, const double *attenuation, unsigned short num_devices)
+{
+    unsigned char payload[DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE - sizeof(ch_dynamic_att_com_protocol_header_t)];
+    ch_dynamic_att_com_protocol_set_att_vector_t *vector = (ch_dynamic_att_com_protocol_set_att_vector_t *)payload;
+    const unsigned short max_count = (sizeof(payload) - sizeof(*vector)) / sizeof(double);
+    unsigned short first = 0U;
+
+    while (first < num_devices) {
+        unsigned short count = (num_devices - first > max_count) ? max_count : num_devices - first;
+
+        vector->device = global_device_nbr;
+        vector->first_peer_device = first;
+        vector->count = count;
+        memcpy(payload + sizeof(*vector), attenuation + first, count*sizeof(double));
+        if (!channel_dynamic_att_client_write_cmd(command, payload, sizeof(*vector) + count*sizeof(double))) {
+            return false;
+        }
+        first += count;
+    }
+    return true;
+}
+
+static void channel_dynamic_att_client_prepare(char *fifo_name, const char *suffix)
 {
     if (!fifo_name) {
         fifo_name = DYNAMIC_ATT_DEFAULT_FIFO_NAME;
     }
 
-    channel_dynamic_att_client_prv.fifo_full_path = bs_calloc(strlen(pb_com_path) + strlen(fifo_name) + 2, sizeof(char));
+    channel_dynamic_att_client_prv.fifo_full_path = bs_calloc(strlen(pb_com_path) + strlen(fifo_name) + strlen(suffix) + 2, sizeof(char));
     if (!channel_dynamic_att_client_prv.fifo_full_path) {
         bs_trace_error("Error allocating memory for fifo path");
     }
-    sprintf(channel_dynamic_att_client_prv.fifo_full_path, "%s/%s", pb_com_path, fifo_name);
+    sprintf(channel_dynamic_att_client_prv.fifo_full_path, "%s/%s%s", pb_com_path, fifo_name, suffix);
+
+    channel_dynamic_att_client_prv.ack_full_path = bs_calloc(strlen(pb_com_path) + strlen(fifo_name) + strlen(DYNAMIC_ATT_ACK_SUFFIX) + 2,
+                                                            sizeof(char));
+    if (!channel_dynamic_att_client_prv.ack_full_path) {
+        bs_trace_error("Error allocating memory for ack page path");
+    }
+    sprintf(channel_dynamic_att_client_prv.ack_full_path, "%s/%s%s", pb_com_path, fifo_name, DYNAMIC_ATT_ACK_SUFFIX);
+}
+
+bool channel_dynamic_att_client_open(char *fifo_name)
+{
+    channel_dynamic_att_client_prepare(fifo_name, "");
 
     if ((channel_dynamic_att_client_prv.fifo_write_handle = open(channel_dynamic_att_client_prv.fifo_full_path, O_WRONLY)) == -1) {
         bs_trace_error("Failed opening fifo for writing");
     }
+    return true;
+}
+
+/*
+ * Whether a mapped ring is ready and its channel is running, rather than left by a channel which crashed
+ */
+static bool channel_dynamic_att_client_ring_is_live(const ch_dynamic_att_shm_ring_t *ring)
+{
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != DYNAMIC_ATT_SHM_RING_MAGIC) {
+        return false;
+    }
+    return kill((pid_t)ring->owner_pid, 0) == 0 || errno == EPERM;
+}
+
+/*
+ * Map the shared memory command ring prepared at fifo_full_path, waiting for the channel to create it
+ */
+static void channel_dynamic_att_client_map_ring(void)
+{
+    struct stat file_stat;
+    void *map;
+    int fd;
+
+    channel_dynamic_att_client_prv.ring_map_size = sizeof(ch_dynamic_att_shm_ring_t) + DYNAMIC_ATT_SHM_RING_SIZE;
+
+    /*
+     * Like opening the fifo, wait for the channel to create its end. The file is opened again on
+     * every try, as the channel replaces a file left from an earlier run.
+     */
+    for (;;) {
+        fd = open(channel_dynamic_att_client_prv.fifo_full_path, O_RDWR);
+        if (fd >= 0 && fstat(fd, &file_stat) == 0 && (size_t)file_stat.st_size >= channel_dynamic_att_client_prv.ring_map_size) {
+            map = mmap(NULL, channel_dynamic_att_client_prv.ring_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED) {
+                bs_trace_error("Failed mapping shared memory for writing");
+            }
+            if (channel_dynamic_att_client_ring_is_live(map)) {
+                close(fd);
+                channel_dynamic_att_client_prv.ring = map;
+                return;
+            }
+            munmap(map, channel_dynamic_att_client_prv.ring_map_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        channel_dynamic_att_client_sleep_us(1000);
+    }
+}
+
+bool channel_dynamic_att_client_open_shm(char *fifo_name)
+{
+    channel_dynamic_att_client_prepare(fifo_name, DYNAMIC_ATT_SHM_RING_SUFFIX);
+    channel_dynamic_att_client_map_ring();
+    return true;
+}
+
+/*
+ * Background writer of the asynchronous mode: connects to the fifo or the shared memory ring, then
+ * moves queued packets to it, several at a time but never more than one atomic fifo write. When the
+ * ring is full, it is this thread which waits for the channel.
+ */
+static void *channel_dynamic_att_client_writer(void *arg)
+{
+    unsigned char batch[DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE];
+    struct timespec deadline;
+    size_t batch_size;
+    size_t packet_size;
+    int fd = -1;
+
+    (void)arg;
+    if (channel_dynamic_att_client_prv.async_shm) {
+        channel_dynamic_att_client_map_ring();
+    } else {
+        /* The device may start before the channel has created the fifo */
+        while ((fd = open(channel_dynamic_att_client_prv.fifo_full_path, O_WRONLY)) == -1) {
+            if (errno != ENOENT) {
+                bs_trace_error("Failed opening fifo for writing");
+            }
+            channel_dynamic_att_client_sleep_us(1000);
+        }
+    }
+
+    for (;;) {
+        batch_size = 0U;
+        while ((packet_size = channel_dynamic_att_client_queue_pop(batch + batch_size, sizeof(batch) - batch_size)) > 0U) {
+            batch_size += packet_size;
+        }
+        if (batch_size) {
+            if (channel_dynamic_att_client_prv.async_shm) {
+                channel_dynamic_att_client_ring_push(batch, batch_size);
+            } else if (write(fd, batch, batch_size) != (ssize_t)batch_size) {
+                bs_trace_error("Failed writing fifo");
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&channel_dynamic_att_client_prv.writer_mutex);
+        __atomic_store_n(&channel_dynamic_att_client_prv.writer_sleeping, true, __ATOMIC_SEQ_CST);
+        if (channel_dynamic_att_client_queue_is_empty()) {
+            if (channel_dynamic_att_client_prv.writer_stop) {
+                pthread_mutex_unlock(&channel_dynamic_att_client_prv.writer_mutex);
+                break;
+            }
+            /* Woken by the device thread, the timeout only guards against a missed wake up */
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 10*1000*1000;
+            if (deadline.tv_nsec >= 1000*1000*1000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000*1000*1000;
+            }
+            pthread_cond_timedwait(&channel_dynamic_att_client_prv.writer_cond, &channel_dynamic_att_client_prv.writer_mutex, &deadline);
+        }
+        __atomic_store_n(&channel_dynamic_att_client_prv.writer_sleeping, false, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&channel_dynamic_att_client_prv.writer_mutex);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    return NULL;
+}
+
+static void channel_dynamic_att_client_start_async(size_t queue_size, channel_dynamic_att_client_queue_policy_t policy)
+{
+    channel_dynamic_att_client_queue_init(queue_size ? queue_size : DYNAMIC_ATT_CLIENT_DEFAULT_QUEUE_SIZE);
+    channel_dynamic_att_client_prv.policy = policy;
+    channel_dynamic_att_client_prv.dropped = 0U;
+    channel_dynamic_att_client_prv.writer_sleeping = false;
+    channel_dynamic_att_client_prv.writer_stop = false;
+
+    if (pthread_mutex_init(&channel_dynamic_att_client_prv.writer_mutex, NULL) != 0 ||
+        pthread_cond_init(&channel_dynamic_att_client_prv.writer_cond, NULL) != 0 ||
+        pthread_create(&channel_dynamic_att_client_prv.writer, NULL, channel_dynamic_att_client_writer, NULL) != 0) {
+        bs_trace_error("Failed starting the command writer thread");
+    }
+    channel_dynamic_att_client_prv.async = true;
+}
+
+bool channel_dynamic_att_client_open_async(char *fifo_name, size_t queue_size, channel_dynamic_att_client_queue_policy_t policy)
+{
+    channel_dynamic_att_client_prepare(fifo_name, "");
+    channel_dynamic_att_client_prv.async_shm = false;
+    channel_dynamic_att_client_start_async(queue_size, policy);
+    return true;
+}
+
+bool channel_dynamic_att_client_open_shm_async(char *fifo_name, size_t queue_size, channel_dynamic_att_client_queue_policy_t policy)
+{
+    channel_dynamic_att_client_prepare(fifo_name, DYNAMIC_ATT_SHM_RING_SUFFIX);
+    channel_dynamic_att_client_prv.async_shm = true;
+    channel_dynamic_att_client_start_async(queue_size, policy);
+    return true;
+}
+
+size_t channel_dynamic_att_client_dropped(void)
+{
+    return channel_dynamic_att_client_prv.dropped;
+}
+
+/*
+ * Hand every held back command to the writer thread, and wait for it to write out the queue and exit
+ */
+static void channel_dynamic_att_client_close_async(void)
+{
+    while (channel_dynamic_att_client_prv.pending_count) {
+        channel_dynamic_att_client_flush();
+        if (channel_dynamic_att_client_prv.pending_count) {
+            channel_dynamic_att_client_wake_writer();
+            channel_dynamic_att_client_sleep_us(10);
+        }
+    }
+
+    pthread_mutex_lock(&channel_dynamic_att_client_prv.writer_mutex);
+    channel_dynamic_att_client_prv.writer_stop = true;
+    pthread_cond_signal(&channel_dynamic_att_client_prv.writer_cond);
+    pthread_mutex_unlock(&channel_dynamic_att_client_prv.writer_mutex);
+    pthread_join(channel_dynamic_att_client_prv.writer, NULL);
+
+    pthread_cond_destroy(&channel_dynamic_att_client_prv.writer_cond);
+    pthread_mutex_destroy(&channel_dynamic_att_client_prv.writer_mutex);
+    channel_dynamic_att_client_queue_free();
+    channel_dynamic_att_client_prv.async = false;
+}
+
+void channel_dynamic_att_client_set_buffered(bool buffered, size_t flush_threshold)
+{
+    if (!buffered) {
+        channel_dynamic_att_client_flush();
+    }
+    channel_dynamic_att_client_prv.buffered = buffered;
+    channel_dynamic_att_client_prv.flush_threshold = flush_threshold ? flush_threshold : DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE;
+}
+
+bool channel_dynamic_att_client_flush(void)
+{
+    bool result = true;
+
+    if (channel_dynamic_att_client_prv.pending_count > channel_dynamic_att_client_prv.pending_first) {
+        bs_trace_raw(8, "channel_dynamic_att_client_flush: Sending %zu bytes\n", channel_dynamic_att_client_prv.pending_bytes);
+        result = channel_dynamic_att_client_write_pending();
+    }
+    if (channel_dynamic_att_client_prv.pending_count && channel_dynamic_att_client_prv.pending_first == channel_dynamic_att_client_prv.pending_count) {
+        channel_dynamic_att_client_clear_pending();
+    }
+    return result;
 }
 
 void channel_dynamic_att_client_close()
 {
+    channel_dynamic_att_client_flush();
+    if (channel_dynamic_att_client_prv.async) {
+        channel_dynamic_att_client_close_async();
+    }
+    free(channel_dynamic_att_client_prv.buffer);
+    free(channel_dynamic_att_client_prv.pending);
+    free(channel_dynamic_att_client_prv.pending_one_by_peer);
+    channel_dynamic_att_client_prv.buffer = NULL;
+    channel_dynamic_att_client_prv.pending = NULL;
+    channel_dynamic_att_client_prv.pending_one_by_peer = NULL;
+    channel_dynamic_att_client_prv.buffer_capacity = 0U;
+    channel_dynamic_att_client_prv.pending_capacity = 0U;
+    channel_dynamic_att_client_prv.pending_one_by_peer_size = 0U;
+    channel_dynamic_att_client_prv.buffered = false;
+
+    if (channel_dynamic_att_client_prv.ring) {
+        munmap(channel_dynamic_att_client_prv.ring, channel_dynamic_att_client_prv.ring_map_size);
+        channel_dynamic_att_client_prv.ring = NULL;
+    }
+
     if (channel_dynamic_att_client_prv.fifo_write_handle >= 0) {
         close(channel_dynamic_att_client_prv.fifo_write_handle);
         channel_dynamic_att_client_prv.fifo_write_handle = -1;
@@ -79,11 +777,24 @@ void channel_dynamic_att_client_close()
         free(channel_dynamic_att_client_prv.fifo_full_path);
         channel_dynamic_att_client_prv.fifo_full_path = NULL;
     }
+
+    if (channel_dynamic_att_client_prv.ack_page) {
+        munmap(channel_dynamic_att_client_prv.ack_page, channel_dynamic_att_client_prv.ack_map_size);
+        channel_dynamic_att_client_prv.ack_page = NULL;
+    }
+    if (channel_dynamic_att_client_prv.ack_full_path) {
+        free(channel_dynamic_att_client_prv.ack_full_path);
+        channel_dynamic_att_client_prv.ack_full_path = NULL;
+    }
 }
 
 bool channel_dynamic_att_client_reset(void)
 {
-    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_RESET, NULL, 0);
+    ch_dynamic_att_com_protocol_reset_t payload = {
+        .device = global_device_nbr
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_RESET, &payload, sizeof(ch_dynamic_att_com_protocol_reset_t));
 }
 
 bool channel_dynamic_att_client_set_attenuation_all(double attentuation)
@@ -107,3 +818,310 @@ bool channel_dynamic_att_client_set_attenuation_one(unsigned short peer_device,
 
     return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE, &payload, sizeof(ch_dynamic_att_com_protocol_set_att_one_t));
 }
+
+bool channel_dynamic_att_client_set_attenuation_bins(unsigned short peer_device, unsigned short first_bin, unsigned short count,
+                                                     double attentuation_rx, double attentuation_tx)
+{
+    ch_dynamic_att_com_protocol_set_att_bin_t payload = {
+        .device         = global_device_nbr,
+        .peer_device    = peer_device,
+        .first_bin      = first_bin,
+        .count          = count,
+        .attenuation_rx = attentuation_rx,
+        .attenuation_tx = attentuation_tx
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_BIN, &payload, sizeof(ch_dynamic_att_com_protocol_set_att_bin_t));
+}
+
+bool channel_dynamic_att_client_set_fading_all(double sigma)
+{
+    ch_dynamic_att_com_protocol_set_fading_all_t payload = {
+        .device = global_device_nbr,
+        .sigma  = sigma
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ALL, &payload, sizeof(ch_dynamic_att_com_protocol_set_fading_all_t));
+}
+
+bool channel_dynamic_att_client_set_fading_one(unsigned short peer_device, double sigma_rx, double sigma_tx)
+{
+    ch_dynamic_att_com_protocol_set_fading_one_t payload = {
+        .device      = global_device_nbr,
+        .peer_device = peer_device,
+        .sigma_rx    = sigma_rx,
+        .sigma_tx    = sigma_tx
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ONE, &payload, sizeof(ch_dynamic_att_com_protocol_set_fading_one_t));
+}
+
+bool channel_dynamic_att_client_set_attenuation_tx(const double *attenuation, unsigned short num_devices)
+{
+    return channel_dynamic_att_client_write_vector(DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX, attenuation, num_devices);
+}
+
+bool channel_dynamic_att_client_set_attenuation_rx(const double *attenuation, unsigned short num_devices)
+{
+    return channel_dynamic_att_client_write_vector(DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_RX, attenuation, num_devices);
+}
+
+bool channel_dynamic_att_client_set_attenuation_list(const channel_dynamic_att_client_link_t *links, size_t count)
+{
+    unsigned char payload[DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE - sizeof(ch_dynamic_att_com_protocol_header_t)];
+    ch_dynamic_att_com_protocol_set_att_list_t *list = (ch_dynamic_att_com_protocol_set_att_list_t *)payload;
+    const size_t max_count = (sizeof(payload) - sizeof(*list)) / sizeof(ch_dynamic_att_com_protocol_link_t);
+    size_t sent = 0U;
+
+    while (sent < count) {
+        size_t chunk = (count - sent > max_count) ? max_count : count - sent;
+
+        list->device = global_device_nbr;
+        list->count = chunk;
+        for (size_t i = 0U; i < chunk; i++) {
+            ch_dynamic_att_com_protocol_link_t link = {
+                .peer_device    = links[sent + i].peer_device,
+                .attenuation_rx = links[sent + i].rx_attenuation,
+                .attenuation_tx = links[sent + i].tx_attenuation
+            };
+            memcpy(payload + sizeof(*list) + i*sizeof(link), &link, sizeof(link));
+        }
+        if (!channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_LST, payload, sizeof(*list) + chunk*sizeof(ch_dynamic_att_com_protocol_link_t))) {
+            return false;
+        }
+        sent += chunk;
+    }
+    return true;
+}
+
+bool channel_dynamic_att_client_set_group(unsigned short group)
+{
+    ch_dynamic_att_com_protocol_set_group_t payload = {
+        .device = global_device_nbr,
+        .group  = group
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP, &payload, sizeof(ch_dynamic_att_com_protocol_set_group_t));
+}
+
+bool channel_dynamic_att_client_set_position(double x, double y, double z)
+{
+    ch_dynamic_att_com_protocol_set_position_t payload = {
+        .device   = global_device_nbr,
+        .position = { x, y, z }
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_POS, &payload, sizeof(ch_dynamic_att_com_protocol_set_position_t));
+}
+
+bool channel_dynamic_att_client_set_offset(double offset)
+{
+    ch_dynamic_att_com_protocol_set_offset_t payload = {
+        .device = global_device_nbr,
+        .offset = offset
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_OFFSET, &payload, sizeof(ch_dynamic_att_com_protocol_set_offset_t));
+}
+
+bool channel_dynamic_att_client_ramp_attenuation(unsigned short peer_device, double start_attenuation, double end_attenuation,
+                                                 bs_time_t start_time, bs_time_t end_time)
+{
+    ch_dynamic_att_com_protocol_ramp_t payload = {
+        .device            = global_device_nbr,
+        .peer_device       = peer_device,
+        .start_attenuation = start_attenuation,
+        .end_attenuation   = end_attenuation,
+        .start_time        = start_time,
+        .end_time          = end_time
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_RAMP, &payload, sizeof(ch_dynamic_att_com_protocol_ramp_t));
+}
+
+bool channel_dynamic_att_client_begin(void)
+{
+    ch_dynamic_att_com_protocol_txn_t payload = {
+        .device = global_device_nbr
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_BEGIN, &payload, sizeof(ch_dynamic_att_com_protocol_txn_t));
+}
+
+bool channel_dynamic_att_client_commit(void)
+{
+    ch_dynamic_att_com_protocol_txn_t payload = {
+        .device = global_device_nbr
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_COMMIT, &payload, sizeof(ch_dynamic_att_com_protocol_txn_t));
+}
+
+static uint32_t channel_dynamic_att_client_next_ack_sequence(void)
+{
+    if (++channel_dynamic_att_client_prv.ack_sequence == 0U) {
+        /* 0 is what the ack page holds before the first acknowledgement */
+        channel_dynamic_att_client_prv.ack_sequence = 1U;
+    }
+    return channel_dynamic_att_client_prv.ack_sequence;
+}
+
+bool channel_dynamic_att_client_request_ack(uint32_t *sequence)
+{
+    ch_dynamic_att_com_protocol_ack_t payload = {
+        .device   = global_device_nbr,
+        .sequence = channel_dynamic_att_client_next_ack_sequence()
+    };
+
+    *sequence = payload.sequence;
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_ACK, &payload, sizeof(ch_dynamic_att_com_protocol_ack_t));
+}
+
+bool channel_dynamic_att_client_request_ack_at(bs_time_t apply_time, uint32_t *sequence)
+{
+    ch_dynamic_att_com_protocol_ack_t payload = {
+        .device   = global_device_nbr,
+        .sequence = channel_dynamic_att_client_next_ack_sequence()
+    };
+
+    *sequence = payload.sequence;
+    return channel_dynamic_att_client_write_cmd_at(apply_time, DYNAMIC_ATT_PROTOCOL_CMD_ACK, &payload, sizeof(ch_dynamic_att_com_protocol_ack_t));
+}
+
+/*
+ * Map the ack page of the channel, if it has created it yet
+ */
+static bool channel_dynamic_att_client_map_ack(void)
+{
+    struct stat file_stat;
+    void *map;
+    int fd;
+
+    if (channel_dynamic_att_client_prv.ack_page) {
+        return true;
+    }
+    if (!channel_dynamic_att_client_prv.ack_full_path) {
+        return false;
+    }
+
+    fd = open(channel_dynamic_att_client_prv.ack_full_path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(ch_dynamic_att_ack_header_t)) {
+        close(fd);
+        return false;
+    }
+    map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    if (__atomic_load_n(&((ch_dynamic_att_ack_header_t *)map)->magic, __ATOMIC_ACQUIRE) != DYNAMIC_ATT_ACK_MAGIC) {
+        /* Not initialized yet */
+        munmap(map, file_stat.st_size);
+        return false;
+    }
+    channel_dynamic_att_client_prv.ack_page = map;
+    channel_dynamic_att_client_prv.ack_map_size = file_stat.st_size;
+    return true;
+}
+
+bool channel_dynamic_att_client_is_applied(uint32_t sequence, bs_time_t *apply_time)
+{
+    const ch_dynamic_att_ack_entry_t *entry;
+    uint32_t version, applied;
+    uint64_t time;
+
+    channel_dynamic_att_client_flush();
+    if (!channel_dynamic_att_client_map_ack()) {
+        return false;
+    }
+    if (global_device_nbr >= channel_dynamic_att_client_prv.ack_page->num_devices ||
+        sizeof(ch_dynamic_att_ack_header_t) + (global_device_nbr + 1U)*sizeof(ch_dynamic_att_ack_entry_t) > channel_dynamic_att_client_prv.ack_map_size) {
+        bs_trace_error_line("Device %u has no entry in the ack page\n", global_device_nbr);
+    }
+    entry = (const ch_dynamic_att_ack_entry_t *)(channel_dynamic_att_client_prv.ack_page + 1) + global_device_nbr;
+
+    /* Sequence lock, see channel_dynamic_att_ack_format.h */
+    do {
+        version = __atomic_load_n(&entry->version, __ATOMIC_ACQUIRE);
+        applied = __atomic_load_n(&entry->sequence, __ATOMIC_RELAXED);
+        time = __atomic_load_n(&entry->apply_time, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((version & 1U) || version != __atomic_load_n(&entry->version, __ATOMIC_RELAXED));
+
+    /* Sequence numbers wrap, so compare their distance */
+    if (applied == 0U || (int32_t)(applied - sequence) < 0) {
+        return false;
+    }
+    if (apply_time) {
+        *apply_time = time;
+    }
+    return true;
+}
+
+bs_time_t channel_dynamic_att_client_wait_applied(uint32_t sequence, unsigned int timeout_ms)
+{
+    struct timespec start, now;
+    bs_time_t apply_time;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (!channel_dynamic_att_client_is_applied(sequence, &apply_time)) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timeout_ms && (now.tv_sec - start.tv_sec)*1000 + (now.tv_nsec - start.tv_nsec)/1000000 >= (long)timeout_ms) {
+            return TIME_NEVER;
+        }
+        channel_dynamic_att_client_sleep_us(100);
+    }
+    return apply_time;
+}
+
+bool channel_dynamic_att_client_set_group_attenuation(unsigned short group, unsigned short peer_group, double attentuation_rx, double attentuation_tx)
+{
+    ch_dynamic_att_com_protocol_set_group_att_t payload = {
+        .group          = group,
+        .peer_group     = peer_group,
+        .attenuation_rx = attentuation_rx,
+        .attenuation_tx = attentuation_tx,
+        .device         = global_device_nbr
+    };
+
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP_ATT, &payload, sizeof(ch_dynamic_att_com_protocol_set_group_att_t));
+}
+
+bool channel_dynamic_att_client_save_snapshot(const char *file_name)
+{
+    return channel_dynamic_att_client_write_cmd(DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT, (void *)file_name, strlen(file_name) + 1U);
+}
+
+bool channel_dynamic_att_client_reset_at(bs_time_t apply_time)
+{
+    ch_dynamic_att_com_protocol_reset_t payload = {
+        .device = global_device_nbr
+    };
+
+    return channel_dynamic_att_client_write_cmd_at(apply_time, DYNAMIC_ATT_PROTOCOL_CMD_RESET, &payload, sizeof(ch_dynamic_att_com_protocol_reset_t));
+}
+
+bool channel_dynamic_att_client_set_attenuation_all_at(bs_time_t apply_time, double attentuation)
+{
+    ch_dynamic_att_com_protocol_set_att_all_t payload = {
+        .device      = global_device_nbr,
+        .attenuation = attentuation
+    };
+
+    return channel_dynamic_att_client_write_cmd_at(apply_time, DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL, &payload, sizeof(ch_dynamic_att_com_protocol_set_att_all_t));
+}
+
+bool channel_dynamic_att_client_set_attenuation_one_at(bs_time_t apply_time, unsigned short peer_device, double attentuation_rx, double attentuation_tx)
+{
+    ch_dynamic_att_com_protocol_set_att_one_t payload = {
+        .device         = global_device_nbr,
+        .peer_device    = peer_device,
+        .attenuation_rx = attentuation_rx,
+        .attenuation_tx = attentuation_tx
+    };
+
+    return channel_dynamic_att_client_write_cmd_at(apply_time, DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE, &payload, sizeof(ch_dynamic_att_com_protocol_set_att_one_t));
+}
@@ -6,6 +6,9 @@
 #ifndef _CHANNEL_DYNAMIC_ATT_CLIENT_H
 #define _CHANNEL_DYNAMIC_ATT_CLIENT_H
 
+#include <stddef.h>
+#include "bs_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -23,6 +26,15 @@ extern "C" {
  * Commands are guaranteed to be sent unfragmented as multiple client may be connected.
  */
 
+/**
+ * Attenuation between this device and one peer, see @ref channel_dynamic_att_client_set_attenuation_list
+ */
+typedef struct {
+    unsigned short peer_device;    /* The device number of the peer */
+    double         rx_attenuation; /* The attenuation in dBm for incoming packets to this device */
+    double         tx_attenuation; /* The attenuation in dBm for outgoing packets from this device */
+} channel_dynamic_att_client_link_t;
+
 /**
  * @brief Initialize dynamic attenuation feature
  *
@@ -35,10 +47,105 @@ extern "C" {
 bool channel_dynamic_att_client_open(char *fifo_name);
 
 /**
- *  @brief Close the fifo opened by @ref channel_dynamic_att_client_open
+ * @brief Initialize dynamic attenuation feature using shared memory
+ *
+ * This will map the shared memory command ring of a ext_2G4_channel_dynamic_att channel started
+ * with -shm. Sending a command is then a copy into shared memory without any system call.
+ * Use this instead of @ref channel_dynamic_att_client_open. Like it, this waits for the channel.
+ * When the ring is full, sending a command waits for the channel to make room, like a full fifo;
+ * use @ref channel_dynamic_att_client_open_shm_async to never wait.
+ *
+ * @param fifo_name Optional name of the fifo. This must correspond to the -fifo_name parameter passed to ext_2G4_channel_dynamic_att.
+ *                  Pass NULL here to use the default name.
+ * @return True on success
+ */
+bool channel_dynamic_att_client_open_shm(char *fifo_name);
+
+/**
+ * What the asynchronous client does when its queue is full, see @ref channel_dynamic_att_client_open_async
+ */
+typedef enum {
+    DYNAMIC_ATT_CLIENT_QUEUE_BLOCK = 0,    /* Wait for the writer thread to make room */
+    DYNAMIC_ATT_CLIENT_QUEUE_DROP_OLDEST,  /* Drop the oldest queued commands to make room, but wait for
+                                              transaction framing, acknowledgements and snapshots */
+    DYNAMIC_ATT_CLIENT_QUEUE_COALESCE,     /* Hold commands back in the client, replacing earlier ones to the same links
+                                              like buffered mode, until there is room */
+} channel_dynamic_att_client_queue_policy_t;
+
+/* Default queue size of the asynchronous client */
+#define DYNAMIC_ATT_CLIENT_DEFAULT_QUEUE_SIZE (64*1024)
+
+/**
+ * @brief Connect to the fifo in the background, and send commands from a background thread
+ *
+ * Returns immediately. A writer thread opens the fifo, waiting for the channel like
+ * @ref channel_dynamic_att_client_open does, and then writes the commands. Commands are put in
+ * a bounded lock-free queue, so sending a command does not block on the fifo; when the queue is
+ * full the policy decides what happens. Commands keep their order.
+ *
+ * @param fifo_name Name of the fifo, NULL for the default
+ * @param queue_size Bytes of queue space, 0 for DYNAMIC_ATT_CLIENT_DEFAULT_QUEUE_SIZE
+ * @param policy What to do when the queue is full
+ * @return True
+ */
+bool channel_dynamic_att_client_open_async(char *fifo_name, size_t queue_size, channel_dynamic_att_client_queue_policy_t policy);
+
+/**
+ * @brief Connect to the shared memory command ring in the background, and send commands from a background thread
+ *
+ * Like @ref channel_dynamic_att_client_open_async, for a channel started with -shm. When the ring
+ * is full, the writer thread waits for the channel to make room, not the device.
+ *
+ * @param fifo_name Name of the fifo, NULL for the default
+ * @param queue_size Bytes of queue space, 0 for DYNAMIC_ATT_CLIENT_DEFAULT_QUEUE_SIZE
+ * @param policy What to do when the queue is full
+ * @return True
+ */
+bool channel_dynamic_att_client_open_shm_async(char *fifo_name, size_t queue_size, channel_dynamic_att_client_queue_policy_t policy);
+
+/**
+ * @brief Number of commands dropped by DYNAMIC_ATT_CLIENT_QUEUE_DROP_OLDEST since the connection was opened
+ */
+size_t channel_dynamic_att_client_dropped(void);
+
+/**
+ *  @brief Close the connection opened by @ref channel_dynamic_att_client_open, @ref channel_dynamic_att_client_open_shm,
+ *  @ref channel_dynamic_att_client_open_async or @ref channel_dynamic_att_client_open_shm_async
+ *
+ *  Pending commands of buffered mode are flushed first. In asynchronous mode this waits until all
+ *  commands are written to the fifo or ring.
  */
 void channel_dynamic_att_client_close(void);
 
+/**
+ * @brief Enable or disable buffered mode
+ *
+ * In buffered mode commands are kept in the client until @ref channel_dynamic_att_client_flush
+ * is called or flush_threshold bytes are pending, and are then sent in as few writes as possible.
+ * While buffered, commands made redundant by a later command are dropped:
+ *   - a reset drops all pending commands, except scheduled ones,
+ *   - setting the attenuation to all devices drops all pending attenuation changes, except scheduled ones and group changes,
+ *   - setting the attenuation to one peer drops a pending change to the same peer,
+ *   - moving this device to a group drops a pending move.
+ * Commands before a commit, an acknowledgement or a snapshot, and these themselves, are never
+ * dropped. Disabling buffered mode flushes pending commands.
+ *
+ * @param buffered True to enable buffered mode
+ * @param flush_threshold Number of pending bytes which triggers an automatic flush.
+ *                        Pass 0 for the default, which is one atomic fifo write.
+ */
+void channel_dynamic_att_client_set_buffered(bool buffered, size_t flush_threshold);
+
+/**
+ * @brief Send all pending commands of buffered mode
+ *
+ * Each write is at most DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE bytes, so writes from several
+ * clients are never interleaved.
+ *
+ * @return True if sending commands is successful
+ */
+bool channel_dynamic_att_client_flush(void);
+
 /**
  * @brief Reset all attenuations to default.
  *
@@ -68,6 +175,270 @@ bool channel_dynamic_att_client_set_attenuation_all(double attentuation);
  */
 bool channel_dynamic_att_client_set_attenuation_one(unsigned short peer_device, double rx_attentuation, double tx_attentuation);
 
+/**
+ * @brief Write attenuation between this device and a peer, in a range of frequency bins only.
+ *
+ * Only valid when the channel runs with frequency bins (-freq_bins). The channel splits the band
+ * from 2400 to 2480 MHz in equally wide bins, and uses the bin of the transmitter's center
+ * frequency. The other commands set the attenuation of all bins.
+ *
+ * @param peer_device The device number of the peer.
+ * @param first_bin The first frequency bin to set.
+ * @param count The number of frequency bins to set.
+ * @param rx_attenuation The attenuation in dBm for incoming packets to this device.
+ * @param tx_attenuation The attenuation in dBm for outgoing packets from this device.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_attenuation_bins(unsigned short peer_device, unsigned short first_bin, unsigned short count,
+                                                     double rx_attentuation, double tx_attentuation);
+
+/**
+ * @brief Write fading standard deviation between this device and all other devices.
+ *
+ * Only valid when the channel runs with fading (-fading). Random fading with this standard
+ * deviation is added to the attenuation of all links with this device, in both directions.
+ *
+ * @param sigma The standard deviation in dB, 0 for no fading.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_fading_all(double sigma);
+
+/**
+ * @brief Write fading standard deviation between this device and a peer.
+ *
+ * Only valid when the channel runs with fading (-fading).
+ *
+ * @param peer_device The device number of the peer.
+ * @param rx_sigma The standard deviation in dB for incoming packets to this device.
+ * @param tx_sigma The standard deviation in dB for outgoing packets from this device.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_fading_one(unsigned short peer_device, double rx_sigma, double tx_sigma);
+
+/**
+ * @brief Write Tx attenuation from this device to all devices.
+ *
+ * This will set the attenuation for outgoing packets from this device to each peer, using as
+ * few commands as possible.
+ *
+ * @param attenuation Array of num_devices attenuations in dBm, indexed by peer device number.
+ *                    The entry for this device is ignored.
+ * @param num_devices Number of entries in attenuation.
+ * @return True if sending commands is successful
+ */
+bool channel_dynamic_att_client_set_attenuation_tx(const double *attenuation, unsigned short num_devices);
+
+/**
+ * @brief Write Rx attenuation from all devices to this device.
+ *
+ * This will set the attenuation for incoming packets to this device from each peer, using as
+ * few commands as possible.
+ *
+ * @param attenuation Array of num_devices attenuations in dBm, indexed by peer device number.
+ *                    The entry for this device is ignored.
+ * @param num_devices Number of entries in attenuation.
+ * @return True if sending commands is successful
+ */
+bool channel_dynamic_att_client_set_attenuation_rx(const double *attenuation, unsigned short num_devices);
+
+/**
+ * @brief Write Rx and Tx attenuation between this device and a list of peers.
+ *
+ * Equivalent to calling @ref channel_dynamic_att_client_set_attenuation_one for each entry,
+ * but using as few commands as possible.
+ *
+ * @param links Array of peers and their attenuations.
+ * @param count Number of entries in links.
+ * @return True if sending commands is successful
+ */
+bool channel_dynamic_att_client_set_attenuation_list(const channel_dynamic_att_client_link_t *links, size_t count);
+
+/**
+ * @brief Move this device to a position.
+ *
+ * Only for a channel running with a path loss model (-pathloss). The attenuation between this
+ * device and all other devices with a position is then computed from their distance.
+ *
+ * @param x, y, z The position in meters.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_position(double x, double y, double z);
+
+/**
+ * @brief Write an attenuation offset for this device.
+ *
+ * Only for a channel running with a path loss model (-pathloss). The offset is added to the
+ * computed attenuation of all links to and from this device, e.g. for antenna gain or body loss.
+ *
+ * @param offset The offset in dB.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_offset(double offset);
+
+/**
+ * @brief Write a linear change of the attenuation between this device and a peer device.
+ *
+ * The channel computes the attenuation of the link at every lookup, so a gradual fade needs a
+ * single command instead of one command per step. The link has start_attenuation until
+ * start_time and end_attenuation from end_time on, in both directions. Setting the attenuation
+ * of the link again stops the ramp.
+ *
+ * @param peer_device The peer device number.
+ * @param start_attenuation The attenuation in dB at start_time.
+ * @param end_attenuation The attenuation in dB at end_time.
+ * @param start_time Simulation time in microseconds at which the ramp starts.
+ * @param end_time Simulation time in microseconds at which the ramp ends, not before start_time.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_ramp_attenuation(unsigned short peer_device, double start_attenuation, double end_attenuation,
+                                                 bs_time_t start_time, bs_time_t end_time);
+
+/**
+ * @brief Begin a transaction.
+ *
+ * The channel holds the following commands of this device until
+ * @ref channel_dynamic_att_client_commit, and then applies them all before its next evaluation,
+ * so the simulation never sees a reconfiguration half done, including one starting with a
+ * reset. Snapshots are not part of the transaction.
+ *
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_begin(void);
+
+/**
+ * @brief Commit the transaction begun with @ref channel_dynamic_att_client_begin.
+ *
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_commit(void);
+
+/**
+ * @brief Ask the channel to acknowledge the commands this device sent so far.
+ *
+ * The channel applies the commands of a client in order, so once it applied the acknowledgement
+ * it applied every command sent before it. Check for that with
+ * @ref channel_dynamic_att_client_is_applied or @ref channel_dynamic_att_client_wait_applied.
+ * Inside a transaction the acknowledgement is applied when the transaction is committed.
+ *
+ * @param sequence Set to the sequence number of the acknowledgement.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_request_ack(uint32_t *sequence);
+
+/**
+ * @brief Ask the channel to acknowledge at a given simulation time.
+ *
+ * Scheduled version of @ref channel_dynamic_att_client_request_ack, which is acknowledged after
+ * the commands scheduled for the same time, see @ref channel_dynamic_att_client_reset_at.
+ *
+ * @param apply_time Simulation time in microseconds at which to acknowledge.
+ * @param sequence Set to the sequence number of the acknowledgement.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_request_ack_at(bs_time_t apply_time, uint32_t *sequence);
+
+/**
+ * @brief Check whether the channel applied an acknowledgement of this device, without blocking.
+ *
+ * In buffered mode pending commands are flushed first.
+ *
+ * @param sequence Sequence number from @ref channel_dynamic_att_client_request_ack.
+ * @param apply_time If not NULL and the acknowledgement was applied, set to the simulation time it
+ *                   was applied at. If a later acknowledgement was applied as well, this is the time
+ *                   of the latest one.
+ * @return True if the acknowledgement, and so every command sent before it, was applied
+ */
+bool channel_dynamic_att_client_is_applied(uint32_t sequence, bs_time_t *apply_time);
+
+/**
+ * @brief Wait until the channel applied an acknowledgement of this device.
+ *
+ * The channel only applies commands when the phy evaluates the channel, which it does not while
+ * it waits for this device. A device must therefore not wait for its own acknowledgements from
+ * inside the simulation, but poll @ref channel_dynamic_att_client_is_applied as simulation time
+ * advances instead. This is meant for test drivers and other processes outside of the phy's lock
+ * step, which is why it gives up after a wall clock timeout.
+ *
+ * @param sequence Sequence number from @ref channel_dynamic_att_client_request_ack.
+ * @param timeout_ms Wall clock time to wait in milliseconds, 0 to wait forever.
+ * @return The simulation time the acknowledgement was applied at (see
+ *         @ref channel_dynamic_att_client_is_applied), or TIME_NEVER on timeout
+ */
+bs_time_t channel_dynamic_att_client_wait_applied(uint32_t sequence, unsigned int timeout_ms);
+
+/**
+ * @brief Move this device to a group.
+ *
+ * Only for a channel running with groups (-groups). Links of this device which have not been set
+ * individually then get the group attenuation between the new group and the group of the peer.
+ *
+ * @param group The group number.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_group(unsigned short group);
+
+/**
+ * @brief Write Rx and Tx attenuation between the devices of two groups.
+ *
+ * Only for a channel running with groups (-groups).
+ *
+ * @param group The group number.
+ * @param peer_group The peer group number. If equal to group, tx_attenuation is used within the group.
+ * @param rx_attenuation The attenuation in dBm for packets from devices in peer_group to devices in group.
+ * @param tx_attenuation The attenuation in dBm for packets from devices in group to devices in peer_group.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_group_attenuation(unsigned short group, unsigned short peer_group, double rx_attentuation, double tx_attentuation);
+
+/**
+ * @brief Make the channel save the attenuation of all links to a snapshot file.
+ *
+ * The snapshot can be loaded by a later simulation with the channel argument -snapshot.
+ * The file is written by the channel when it handles the command.
+ *
+ * @param file_name The file name, relative to the working directory of the channel.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_save_snapshot(const char *file_name);
+
+/**
+ * @brief Reset all attenuations to default at a given simulation time.
+ *
+ * Scheduled commands are applied by the channel when simulation time reaches apply_time,
+ * independently of when the command is received. Commands scheduled for the same time are
+ * applied in the order they are sent. A time in the past is applied as soon as received.
+ *
+ * @param apply_time Simulation time in microseconds at which the reset happens.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_reset_at(bs_time_t apply_time);
+
+/**
+ * @brief Write attenuation between this device and all others at a given simulation time.
+ *
+ * Scheduled version of @ref channel_dynamic_att_client_set_attenuation_all,
+ * see @ref channel_dynamic_att_client_reset_at.
+ *
+ * @param apply_time Simulation time in microseconds at which the attenuation changes.
+ * @param attenuation The attenuation in dBm.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_attenuation_all_at(bs_time_t apply_time, double attentuation);
+
+/**
+ * @brief Write attenuation between this device and a peer at a given simulation time.
+ *
+ * Scheduled version of @ref channel_dynamic_att_client_set_attenuation_one,
+ * see @ref channel_dynamic_att_client_reset_at.
+ *
+ * @param apply_time Simulation time in microseconds at which the attenuation changes.
+ * @param peer_device The device number of the peer.
+ * @param rx_attenuation The attenuation in dBm for incoming packets to this device.
+ * @param tx_attenuation The attenuation in dBm for outgoing packets from this device.
+ * @return True if sending command is successful
+ */
+bool channel_dynamic_att_client_set_attenuation_one_at(bs_time_t apply_time, unsigned short peer_device, double rx_attentuation, double tx_attentuation);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <string.h>
+#include "bs_oswrap.h"
+#include "bs_tracing.h"
+#include "channel_dynamic_att_client_queue.h"
+#include "channel_dynamic_att_com_protocol.h"
+
+/*
+ * The queue is a byte ring of records, laid out like the shared memory command ring
+ * (channel_dynamic_att_shm_ring.h): each record starts 8 byte aligned with its total length and
+ * packet size, followed by the packet, and a record never wraps; a padding record fills the end
+ * of the ring instead.
+ *
+ * Only the producer advances tail. Both sides advance head: the consumer after copying a record
+ * out, and the producer when it drops the oldest record. Both do so with compare-and-swap, so a
+ * consumer whose record was dropped while it was copying it sees the swap fail and discards the
+ * copy. The producer only reuses space after head has moved past it.
+ *
+ * Records holding transaction framing, acknowledgements or snapshots are never dropped: losing a
+ * CMD_BEGIN or CMD_COMMIT would break up or leave open a transaction, losing a CMD_ACK would leave
+ * the client waiting, and losing a CMD_SNAPSHOT would silently not write the file. The producer
+ * waits for the consumer to take such a record instead.
+ */
+
+#define DYNAMIC_ATT_CLIENT_QUEUE_MIN_SIZE (2*DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE)
+#define DYNAMIC_ATT_CLIENT_QUEUE_PAD_FLAG (0x80000000U)
+
+typedef struct {
+    uint32_t length;      /* Of the whole record including padding, with PAD_FLAG for padding records */
+    uint32_t packet_size;
+} ch_dynamic_att_client_queue_record_t;
+
+static struct {
+    unsigned char *data;
+    uint64_t       size;
+    uint64_t       head __attribute__((aligned(64)));
+    uint64_t       tail __attribute__((aligned(64)));
+} channel_dynamic_att_client_queue_prv = {0};
+
+void channel_dynamic_att_client_queue_init(size_t size)
+{
+    uint64_t ring_size = DYNAMIC_ATT_CLIENT_QUEUE_MIN_SIZE;
+
+    while (ring_size < size) {
+        ring_size *= 2U;
+    }
+    channel_dynamic_att_client_queue_prv.data = bs_calloc(ring_size, sizeof(unsigned char));
+    if (!channel_dynamic_att_client_queue_prv.data) {
+        bs_trace_error("Error allocating memory for the command queue");
+    }
+    channel_dynamic_att_client_queue_prv.size = ring_size;
+    channel_dynamic_att_client_queue_prv.head = 0U;
+    channel_dynamic_att_client_queue_prv.tail = 0U;
+}
+
+void channel_dynamic_att_client_queue_free(void)
+{
+    free(channel_dynamic_att_client_queue_prv.data);
+    channel_dynamic_att_client_queue_prv.data = NULL;
+}
+
+static ch_dynamic_att_client_queue_record_t *channel_dynamic_att_client_queue_record(uint64_t pos)
+{
+    return (ch_dynamic_att_client_queue_record_t *)(channel_dynamic_att_client_queue_prv.data + (pos & (channel_dynamic_att_client_queue_prv.size - 1U)));
+}
+
+bool channel_dynamic_att_client_queue_try_push(const void *packet, size_t packet_size)
+{
+    uint64_t size = channel_dynamic_att_client_queue_prv.size;
+    uint64_t tail = channel_dynamic_att_client_queue_prv.tail;
+    uint32_t length = (sizeof(ch_dynamic_att_client_queue_record_t) + packet_size + 7U) & ~7U;
+    uint64_t pad = ((tail & (size - 1U)) + length > size) ? size - (tail & (size - 1U)) : 0U;
+    ch_dynamic_att_client_queue_record_t *record;
+
+    if (tail + pad + length - __atomic_load_n(&channel_dynamic_att_client_queue_prv.head, __ATOMIC_ACQUIRE) > size) {
+        return false;
+    }
+
+    if (pad) {
+        channel_dynamic_att_client_queue_record(tail)->length = (uint32_t)pad | DYNAMIC_ATT_CLIENT_QUEUE_PAD_FLAG;
+    }
+    record = channel_dynamic_att_client_queue_record(tail + pad);
+    record->length = length;
+    record->packet_size = packet_size;
+    memcpy(record + 1, packet, packet_size);
+    /* Sequentially consistent, so the writer thread cannot miss the packet while going to sleep */
+    __atomic_store_n(&channel_dynamic_att_client_queue_prv.tail, tail + pad + length, __ATOMIC_SEQ_CST);
+
+    return true;
+}
+
+/*
+ * True if the record holds a packet which must reach the channel. A record may hold several packets.
+ */
+static bool channel_dynamic_att_client_queue_must_keep(const ch_dynamic_att_client_queue_record_t *record)
+{
+    const unsigned char *data = (const unsigned char *)(record + 1);
+    const unsigned char *end = data + record->packet_size;
+
+    while (data + sizeof(ch_dynamic_att_com_protocol_header_t) <= end) {
+        const ch_dynamic_att_com_protocol_packet_t *packet = (const ch_dynamic_att_com_protocol_packet_t *)data;
+        unsigned short command = packet->header.command;
+
+        if (command == DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME) {
+            const ch_dynamic_att_com_protocol_at_time_t *at_time = (const ch_dynamic_att_com_protocol_at_time_t *)&packet->payload;
+
+            command = ((const ch_dynamic_att_com_protocol_packet_t *)at_time->packet)->header.command;
+        }
+        if (command == DYNAMIC_ATT_PROTOCOL_CMD_BEGIN || command == DYNAMIC_ATT_PROTOCOL_CMD_COMMIT ||
+            command == DYNAMIC_ATT_PROTOCOL_CMD_ACK || command == DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT) {
+            return true;
+        }
+        data += sizeof(ch_dynamic_att_com_protocol_header_t) + packet->header.payload_size;
+    }
+    return false;
+}
+
+bool channel_dynamic_att_client_queue_drop_oldest(void)
+{
+    uint64_t tail = channel_dynamic_att_client_queue_prv.tail;
+    uint64_t head = __atomic_load_n(&channel_dynamic_att_client_queue_prv.head, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        const ch_dynamic_att_client_queue_record_t *record = channel_dynamic_att_client_queue_record(head);
+        uint32_t length = record->length;
+        bool is_pad = length & DYNAMIC_ATT_CLIENT_QUEUE_PAD_FLAG;
+
+        length &= ~DYNAMIC_ATT_CLIENT_QUEUE_PAD_FLAG;
+        /* Only the producer writes records, so this one stays intact even if the consumer takes it meanwhile */
+        if (!is_pad && channel_dynamic_att_client_queue_must_keep(record)) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&channel_dynamic_att_client_queue_prv.head, &head, head + length, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            if (!is_pad) {
+                return true;
+            }
+            head += length;
+        }
+        /* Else the consumer took the record first, head now holds its new value */
+    }
+    return false;
+}
+
+size_t channel_dynamic_att_client_queue_pop(void *buffer, size_t buffer_size)
+{
+    uint64_t head = __atomic_load_n(&channel_dynamic_att_client_queue_prv.head, __ATOMIC_ACQUIRE);
+
+    while (head != __atomic_load_n(&channel_dynamic_att_client_queue_prv.tail, __ATOMIC_ACQUIRE)) {
+        const ch_dynamic_att_client_queue_record_t *record = channel_dynamic_att_client_queue_record(head);
+        uint32_t length = record->length;
+        uint32_t packet_size = record->packet_size;
+        bool is_pad = length & DYNAMIC_ATT_CLIENT_QUEUE_PAD_FLAG;
+
+        length &= ~DYNAMIC_ATT_CLIENT_QUEUE_PAD_FLAG;
+        if (!is_pad) {
+            /* The record may be dropped and overwritten meanwhile, only trust the copy if the swap succeeds */
+            if (packet_size > DYNAMIC_ATT_PROTOCOL_MAX_PACKET_SIZE) {
+                head = __atomic_load_n(&channel_dynamic_att_client_queue_prv.head, __ATOMIC_ACQUIRE);
+                continue;
+            }
+            if (packet_size > buffer_size) {
+                return 0U;
+            }
+            memcpy(buffer, record + 1, packet_size);
+        }
+        if (__atomic_compare_exchange_n(&channel_dynamic_att_client_queue_prv.head, &head, head + length, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            if (!is_pad) {
+                return packet_size;
+            }
+            head += length;
+        }
+    }
+    return 0U;
+}
+
+bool channel_dynamic_att_client_queue_is_empty(void)
+{
+    return __atomic_load_n(&channel_dynamic_att_client_queue_prv.head, __ATOMIC_ACQUIRE) ==
+           __atomic_load_n(&channel_dynamic_att_client_queue_prv.tail, __ATOMIC_SEQ_CST);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_CLIENT_QUEUE_H
+#define _CHANNEL_DYNAMIC_ATT_CLIENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Bounded lock-free packet queue between the device thread (producer) and the background writer
+ * thread (consumer) of the asynchronous client. Internal to the client library.
+ */
+
+/**
+ * @brief Allocate the queue
+ *
+ * @param size Bytes of queue space, rounded up to a power of two
+ */
+void channel_dynamic_att_client_queue_init(size_t size);
+
+/**
+ * @brief Free the queue
+ */
+void channel_dynamic_att_client_queue_free(void);
+
+/**
+ * @brief Add a packet to the queue, if there is room. Producer only.
+ */
+bool channel_dynamic_att_client_queue_try_push(const void *packet, size_t packet_size);
+
+/**
+ * @brief Drop the oldest packet in the queue. Producer only.
+ *
+ * Packets with transaction framing, acknowledgements or snapshots are never dropped.
+ *
+ * @return False if the queue was empty, or the oldest packet must not be dropped
+ */
+bool channel_dynamic_att_client_queue_drop_oldest(void);
+
+/**
+ * @brief Take the oldest packet from the queue, if it fits in the buffer. Consumer only.
+ *
+ * @return Size of the packet, or 0 if the queue is empty or the packet does not fit
+ */
+size_t channel_dynamic_att_client_queue_pop(void *buffer, size_t buffer_size);
+
+/**
+ * @brief True if no packet is queued
+ */
+bool channel_dynamic_att_client_queue_is_empty(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_CLIENT_QUEUE_H */
@@ -6,73 +6,105 @@
 #include "bs_types.h"
 #include "bs_tracing.h"
 #include "bs_oswrap.h"
+#include "channel_dynamic_att_ack.h"
 #include "channel_dynamic_att_args.h"
 #include "channel_dynamic_att_com.h"
+#include "channel_dynamic_att_defaults.h"
+#include "channel_dynamic_att_fading.h"
+#include "channel_dynamic_att_inner.h"
+#include "channel_dynamic_att_journal.h"
+#include "channel_dynamic_att_matrix.h"
+#include "channel_dynamic_att_position.h"
+#include "channel_dynamic_att_ramp.h"
+#include "channel_dynamic_att_sched.h"
+#include "channel_dynamic_att_snapshot.h"
+#include "channel_dynamic_att_stats.h"
+#include "channel_dynamic_att_timeline.h"
+#include "channel_dynamic_att_txn.h"
 #include "channel_if.h"
 
+/* Width of the 2.4 GHz band split in frequency bins, in MHz from 2400 MHz */
+#define DYNAMIC_ATT_FREQ_BAND_WIDTH (80)
+
 static struct {
-    double  default_attenuation;
-    uint    num_devices;
-    double *attenuation_matrix;
+    double    default_attenuation;
+    uint      num_devices;
+    uint      num_freq_bins;
+    bs_time_t now;
+    bs_time_t check_interval;
+    bs_time_t next_check;
+    void    (*lookup)(const uint *tx_used, const tx_el_t *tx_list, uint rx, bs_time_t now, double *att);
 } ch_dynamic_att_prv = {0};
 
 /*
- * The attenuation matrix is organized as rows for the Tx device and columns for the Rx device.
- * To find the attenuation between two devices select the Tx device row and then the Rx column.
- * Note that attenuation can be different for each direction.
- *
- * This is an example of the attenuation matrix when attenuation is set to 100 dBm between
- * device 2 and all the others:
- *
- *    \ Rx 0   1   2   3
- *   Tx +----------------
- *    0 |  -   d  100  d
- *    1 |  d   -  100  d
- *    2 | 100 100  -  100
- *    3 |  d   d  100  -
- *
- * This is an example of the attenuation matrix when Rx attenuation to (this) device 0 and 3 is
- * set to 99 dBm and Tx attenuation is set to 77 dBm:
- *
- *    \ Rx 0   1   2   3
- *   Tx +----------------
- *    0 |  -   d   d   99
- *    1 |  d   -   d   d
- *    2 |  d   d   -   d
- *    3 |  77  d   d   -
- *
- *  Legend: 'd' is the default attenuation.
+ * Set the attenuation of a link from a command. With positions the row is first brought up to
+ * date, so a pending recompute of the link cannot overwrite the newer value later. A ramp on the
+ * link is stopped, as the newer value replaces it.
  */
+static void channel_dynamic_att_set_link(uint tx, uint rx, double attenuation)
+{
+    bool symmetric = channel_dynamic_att_matrix_is_symmetric();
 
-static void channel_dynamic_att_reset_matrix(void)
+    if (channel_dynamic_att_position_is_enabled()) {
+        channel_dynamic_att_position_refresh(rx);
+        if (symmetric) {
+            channel_dynamic_att_position_refresh(tx);
+        }
+    }
+    if (channel_dynamic_att_ramp_count()) {
+        channel_dynamic_att_ramp_cancel(tx, rx, ch_dynamic_att_prv.now, NULL);
+        if (symmetric) {
+            channel_dynamic_att_ramp_cancel(rx, tx, ch_dynamic_att_prv.now, NULL);
+        }
+    }
+    channel_dynamic_att_matrix_set(tx, rx, attenuation);
+}
+
+/*
+ * Set both directions of a link. With symmetric storage this is a single write, and a different
+ * attenuation per direction is flagged and the Tx attenuation of the device kept.
+ */
+static void channel_dynamic_att_set_link_pair(uint device, uint peer_device, double attenuation_tx, double attenuation_rx)
 {
-    if (ch_dynamic_att_prv.attenuation_matrix) {
-        for (uint device = 0; device < ch_dynamic_att_prv.num_devices*ch_dynamic_att_prv.num_devices; device++) {
-            ch_dynamic_att_prv.attenuation_matrix[device] = ch_dynamic_att_prv.default_attenuation;
+    if (channel_dynamic_att_matrix_is_symmetric()) {
+        if (attenuation_tx != attenuation_rx) {
+            bs_trace_warning_line_time("Device %u set an asymmetric link to device %u (%lf, %lf) with symmetric storage, using %lf\n",
+                                       device, peer_device, attenuation_tx, attenuation_rx, attenuation_tx);
         }
+        channel_dynamic_att_set_link(device, peer_device, attenuation_tx);
+        return;
     }
+    /* Update tx attenuation */
+    channel_dynamic_att_set_link(device, peer_device, attenuation_tx);
+    /* Update rx attenuation */
+    channel_dynamic_att_set_link(peer_device, device, attenuation_rx);
 }
 
-static double *channel_dynamic_att_get_att_ptr(unsigned short row, unsigned short col)
+/*
+ * Stop the ramp of a link before only some of its frequency bins are set, keeping the attenuation
+ * it reached in the other bins
+ */
+static void channel_dynamic_att_stop_ramp(uint tx, uint rx)
 {
-    return ch_dynamic_att_prv.attenuation_matrix + row*ch_dynamic_att_prv.num_devices + col;
+    double attenuation;
+
+    if (channel_dynamic_att_ramp_cancel(tx, rx, ch_dynamic_att_prv.now, &attenuation)) {
+        channel_dynamic_att_matrix_set(tx, rx, attenuation);
+    }
 }
 
-static void channel_dynamic_att_set_all_for_dev(ch_dynamic_att_com_protocol_set_att_all_t *payload)
+static void channel_dynamic_att_set_all_for_dev(const ch_dynamic_att_com_protocol_set_att_all_t *payload)
 {
     if (payload->device >= ch_dynamic_att_prv.num_devices) {
         bs_trace_error_line("Error: device parameter is out of bounds\n");
     }
 
     for (uint dev = 0U; dev < ch_dynamic_att_prv.num_devices; dev++) {
-        /* Update tx row */
-        *channel_dynamic_att_get_att_ptr(payload->device, dev) = payload->attenuation;
-        /* Update rx column */
-        *channel_dynamic_att_get_att_ptr(dev, payload->device) = payload->attenuation;
+        channel_dynamic_att_set_link_pair(payload->device, dev, payload->attenuation, payload->attenuation);
     }
 }
 
-static void channel_dynamic_att_set_one_for_dev(ch_dynamic_att_com_protocol_set_att_one_t *payload)
+static void channel_dynamic_att_set_one_for_dev(const ch_dynamic_att_com_protocol_set_att_one_t *payload)
 {
     if (payload->device >= ch_dynamic_att_prv.num_devices) {
         bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
@@ -81,36 +113,475 @@ static void channel_dynamic_att_set_one_for_dev(ch_dynamic_att_com_protocol_set_
         bs_trace_error_line("Error: peer_device parameter is out of bounds: %u\n", payload->peer_device);
     }
 
-    /* Update tx attenuation */
-    *channel_dynamic_att_get_att_ptr(payload->device, payload->peer_device) = payload->attenuation_tx;
+    channel_dynamic_att_set_link_pair(payload->device, payload->peer_device, payload->attenuation_tx, payload->attenuation_rx);
+}
+
+static void channel_dynamic_att_set_vector_for_dev(unsigned short command, const ch_dynamic_att_com_protocol_set_att_vector_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+    if (payload->first_peer_device + payload->count > ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: peer device range is out of bounds: %u..%u\n", payload->first_peer_device, payload->first_peer_device + payload->count);
+    }
+
+    for (uint i = 0U; i < payload->count; i++) {
+        uint peer = payload->first_peer_device + i;
+
+        if (peer == payload->device) {
+            continue;
+        }
+        if (command == DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX) {
+            channel_dynamic_att_set_link(payload->device, peer, payload->attenuation[i]);
+        } else {
+            channel_dynamic_att_set_link(peer, payload->device, payload->attenuation[i]);
+        }
+    }
+}
+
+static void channel_dynamic_att_set_list_for_dev(const ch_dynamic_att_com_protocol_set_att_list_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+
+    for (uint i = 0U; i < payload->count; i++) {
+        const ch_dynamic_att_com_protocol_link_t *link = &payload->links[i];
+
+        if (link->peer_device >= ch_dynamic_att_prv.num_devices || payload->device == link->peer_device) {
+            bs_trace_error_line("Error: peer_device parameter is out of bounds: %u\n", link->peer_device);
+        }
+        channel_dynamic_att_set_link_pair(payload->device, link->peer_device, link->attenuation_tx, link->attenuation_rx);
+    }
+}
+
+static void channel_dynamic_att_set_bin_for_dev(const ch_dynamic_att_com_protocol_set_att_bin_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+    if (payload->peer_device >= ch_dynamic_att_prv.num_devices || payload->device == payload->peer_device) {
+        bs_trace_error_line("Error: peer_device parameter is out of bounds: %u\n", payload->peer_device);
+    }
+    if (payload->first_bin + payload->count > ch_dynamic_att_prv.num_freq_bins) {
+        bs_trace_error_line("Error: frequency bin range is out of bounds: %u..%u\n", payload->first_bin, payload->first_bin + payload->count);
+    }
+
+    if (channel_dynamic_att_matrix_is_symmetric()) {
+        /* Symmetric storage has a single bin, so this sets the whole link */
+        if (payload->count) {
+            channel_dynamic_att_set_link_pair(payload->device, payload->peer_device, payload->attenuation_tx, payload->attenuation_rx);
+        }
+        return;
+    }
+    if (channel_dynamic_att_position_is_enabled()) {
+        channel_dynamic_att_position_refresh(payload->device);
+        channel_dynamic_att_position_refresh(payload->peer_device);
+    }
+    if (channel_dynamic_att_ramp_count()) {
+        channel_dynamic_att_stop_ramp(payload->device, payload->peer_device);
+        channel_dynamic_att_stop_ramp(payload->peer_device, payload->device);
+    }
+    for (uint bin = payload->first_bin; bin < payload->first_bin + payload->count; bin++) {
+        /* Update tx attenuation */
+        channel_dynamic_att_matrix_set_bin(payload->device, payload->peer_device, bin, payload->attenuation_tx);
+        /* Update rx attenuation */
+        channel_dynamic_att_matrix_set_bin(payload->peer_device, payload->device, bin, payload->attenuation_rx);
+    }
+}
+
+static void channel_dynamic_att_ramp_for_dev(const ch_dynamic_att_com_protocol_ramp_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+    if (payload->peer_device >= ch_dynamic_att_prv.num_devices || payload->device == payload->peer_device) {
+        bs_trace_error_line("Error: peer_device parameter is out of bounds: %u\n", payload->peer_device);
+    }
+    if (payload->end_time < payload->start_time) {
+        bs_trace_error_line("Error: ramp ends (%"PRItime") before it starts (%"PRItime")\n", (bs_time_t)payload->end_time, (bs_time_t)payload->start_time);
+    }
+
+    channel_dynamic_att_ramp_add(payload->device, payload->peer_device, payload->start_attenuation, payload->end_attenuation,
+                                 payload->start_time, payload->end_time);
+    channel_dynamic_att_ramp_add(payload->peer_device, payload->device, payload->start_attenuation, payload->end_attenuation,
+                                 payload->start_time, payload->end_time);
+}
+
+static void channel_dynamic_att_set_fading_all_for_dev(const ch_dynamic_att_com_protocol_set_fading_all_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+    if (payload->sigma < 0.0) {
+        bs_trace_error_line("Error: fading standard deviation is negative: %lf\n", payload->sigma);
+    }
+
+    channel_dynamic_att_fading_set_device(payload->device, payload->sigma);
+}
+
+static void channel_dynamic_att_set_fading_one_for_dev(const ch_dynamic_att_com_protocol_set_fading_one_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+    if (payload->peer_device >= ch_dynamic_att_prv.num_devices || payload->device == payload->peer_device) {
+        bs_trace_error_line("Error: peer_device parameter is out of bounds: %u\n", payload->peer_device);
+    }
+    if (payload->sigma_rx < 0.0 || payload->sigma_tx < 0.0) {
+        bs_trace_error_line("Error: fading standard deviation is negative: %lf, %lf\n", payload->sigma_rx, payload->sigma_tx);
+    }
+
+    /* Update tx fading */
+    channel_dynamic_att_fading_set(payload->device, payload->peer_device, payload->sigma_tx);
+    /* Update rx fading */
+    channel_dynamic_att_fading_set(payload->peer_device, payload->device, payload->sigma_rx);
+}
+
+static void channel_dynamic_att_set_position_for_dev(const ch_dynamic_att_com_protocol_set_position_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+
+    channel_dynamic_att_position_set(payload->device, payload->position[0], payload->position[1], payload->position[2]);
+}
+
+static void channel_dynamic_att_set_offset_for_dev(const ch_dynamic_att_com_protocol_set_offset_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+
+    channel_dynamic_att_position_set_offset(payload->device, payload->offset);
+}
+
+static void channel_dynamic_att_set_group_for_dev(const ch_dynamic_att_com_protocol_set_group_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+    if (payload->group >= channel_dynamic_att_matrix_num_groups()) {
+        bs_trace_error_line("Error: group parameter is out of bounds: %u\n", payload->group);
+    }
+
+    channel_dynamic_att_matrix_set_group(payload->device, payload->group);
+}
+
+static void channel_dynamic_att_set_group_att(const ch_dynamic_att_com_protocol_set_group_att_t *payload)
+{
+    if (payload->group >= channel_dynamic_att_matrix_num_groups() || payload->peer_group >= channel_dynamic_att_matrix_num_groups()) {
+        bs_trace_error_line("Error: group parameters are out of bounds: %u, %u\n", payload->group, payload->peer_group);
+    }
+
     /* Update rx attenuation */
-    *channel_dynamic_att_get_att_ptr(payload->peer_device, payload->device) = payload->attenuation_tx;
-}
-
-static void channel_dynamic_att_check(void)
-{
-    ch_dynamic_att_com_protocol_packet_t packet = {0};
-
-    if (channel_dynamic_att_com_read_packet(&packet)) {
-        switch (packet.header.command) {
-            case DYNAMIC_ATT_PROTOCOL_CMD_RESET:
-                channel_dynamic_att_reset_matrix();
-                bs_trace_raw(8, "All attenuation settings was reset to default (%lu)\n", ch_dynamic_att_prv.default_attenuation);
-                break;
-            case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL:
-                channel_dynamic_att_set_all_for_dev(&packet.payload.set_att_all_payload);
-                bs_trace_raw(8, "Updated attenuation for all connections with device %u\n", packet.payload.set_att_all_payload.device);
-                break;
-            case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE:
-                channel_dynamic_att_set_one_for_dev(&packet.payload.set_att_one_payload);
-                bs_trace_raw(8, "Updated attenuation for connections between device %u and %u\n", packet.payload.set_att_one_payload.device, packet.payload.set_att_one_payload.peer_device);
-                break;
-            default:
-                bs_trace_warning_line_time("Received unknown command %u\n", packet.payload.set_att_all_payload.device);
+    channel_dynamic_att_matrix_set_group_att(payload->peer_group, payload->group, payload->attenuation_rx);
+    /* Update tx attenuation, which also covers the links within a group */
+    channel_dynamic_att_matrix_set_group_att(payload->group, payload->peer_group, payload->attenuation_tx);
+}
+
+/*
+ * The device number a command is sent for, which decides whether it belongs to a transaction.
+ * Transaction framing itself is never held, and neither are resets and group attenuation sent
+ * without a device number.
+ */
+static bool channel_dynamic_att_packet_device(const ch_dynamic_att_com_protocol_packet_t *packet, uint *device)
+{
+    const ch_dynamic_att_com_protocol_at_time_t *at_time;
+
+    switch (packet->header.command) {
+        case DYNAMIC_ATT_PROTOCOL_CMD_RESET:
+            if (packet->header.payload_size != sizeof(ch_dynamic_att_com_protocol_reset_t)) {
+                return false;
+            }
+            *device = packet->payload.reset_payload.device;
+            return true;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP_ATT:
+            if (packet->header.payload_size != sizeof(ch_dynamic_att_com_protocol_set_group_att_t)) {
+                return false;
+            }
+            *device = packet->payload.set_group_att_payload.device;
+            return true;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT:
+        case DYNAMIC_ATT_PROTOCOL_CMD_BEGIN:
+        case DYNAMIC_ATT_PROTOCOL_CMD_COMMIT:
+            return false;
+        case DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME:
+            at_time = (const ch_dynamic_att_com_protocol_at_time_t *)&packet->payload;
+            return channel_dynamic_att_packet_device((const ch_dynamic_att_com_protocol_packet_t *)at_time->packet, device);
+        default:
+            /* All other payloads start with the device number */
+            *device = packet->payload.set_att_all_payload.device;
+            return true;
+    }
+}
+
+static void channel_dynamic_att_begin_for_dev(const ch_dynamic_att_com_protocol_txn_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+
+    channel_dynamic_att_txn_begin(payload->device);
+}
+
+static void channel_dynamic_att_ack_for_dev(const ch_dynamic_att_com_protocol_ack_t *payload)
+{
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+
+    channel_dynamic_att_ack_set(payload->device, payload->sequence, ch_dynamic_att_prv.now);
+}
+
+static void channel_dynamic_att_apply(const ch_dynamic_att_com_protocol_packet_t *packet);
+
+static void channel_dynamic_att_commit_for_dev(const ch_dynamic_att_com_protocol_txn_t *payload)
+{
+    const ch_dynamic_att_com_protocol_packet_t *held;
+
+    if (payload->device >= ch_dynamic_att_prv.num_devices) {
+        bs_trace_error_line("Error: device parameter is out of bounds: %u\n", payload->device);
+    }
+
+    if (!channel_dynamic_att_txn_commit(payload->device)) {
+        bs_trace_warning_line_time("Device %u committed without an open transaction\n", payload->device);
+        return;
+    }
+    while ((held = channel_dynamic_att_txn_next(payload->device)) != NULL) {
+        channel_dynamic_att_apply(held);
+    }
+}
+
+static void channel_dynamic_att_apply(const ch_dynamic_att_com_protocol_packet_t *packet)
+{
+    const ch_dynamic_att_com_protocol_set_att_vector_t *vector;
+    const ch_dynamic_att_com_protocol_set_att_list_t *list;
+    const ch_dynamic_att_com_protocol_at_time_t *at_time;
+    uint device;
+
+    if (channel_dynamic_att_txn_open_count() && channel_dynamic_att_packet_device(packet, &device) &&
+        channel_dynamic_att_txn_is_open(device)) {
+        /* Counted and recorded when the transaction is committed */
+        channel_dynamic_att_txn_hold(device, packet);
+        return;
+    }
+
+    channel_dynamic_att_stats_command(packet->header.command);
+    if (packet->header.command != DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME &&
+        packet->header.command != DYNAMIC_ATT_PROTOCOL_CMD_BEGIN &&
+        packet->header.command != DYNAMIC_ATT_PROTOCOL_CMD_COMMIT &&
+        packet->header.command != DYNAMIC_ATT_PROTOCOL_CMD_ACK) {
+        /*
+         * Scheduled commands are recorded when they are applied, and committed commands when committed.
+         * Acks have no effect on the attenuation, and no clients wait for them in a replay.
+         */
+        channel_dynamic_att_journal_record(ch_dynamic_att_prv.now, packet);
+    }
+
+    switch (packet->header.command) {
+        case DYNAMIC_ATT_PROTOCOL_CMD_RESET:
+            channel_dynamic_att_matrix_reset();
+            channel_dynamic_att_ramp_reset();
+            channel_dynamic_att_fading_reset();
+            if (channel_dynamic_att_position_is_enabled()) {
+                channel_dynamic_att_position_reset();
+            }
+            bs_trace_raw(8, "All attenuation settings was reset to default (%lf)\n", ch_dynamic_att_prv.default_attenuation);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL:
+            channel_dynamic_att_set_all_for_dev(&packet->payload.set_att_all_payload);
+            bs_trace_raw(8, "Updated attenuation for all connections with device %u\n", packet->payload.set_att_all_payload.device);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE:
+            channel_dynamic_att_set_one_for_dev(&packet->payload.set_att_one_payload);
+            bs_trace_raw(8, "Updated attenuation for connections between device %u and %u\n", packet->payload.set_att_one_payload.device, packet->payload.set_att_one_payload.peer_device);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_RX:
+            vector = (const ch_dynamic_att_com_protocol_set_att_vector_t *)&packet->payload;
+            channel_dynamic_att_set_vector_for_dev(packet->header.command, vector);
+            bs_trace_raw(8, "Updated %s attenuation for %u connections with device %u\n",
+                         packet->header.command == DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX ? "Tx" : "Rx", vector->count, vector->device);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_LST:
+            list = (const ch_dynamic_att_com_protocol_set_att_list_t *)&packet->payload;
+            channel_dynamic_att_set_list_for_dev(list);
+            bs_trace_raw(8, "Updated attenuation for %u connections with device %u\n", list->count, list->device);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP_ATT:
+            if (!channel_dynamic_att_matrix_num_groups()) {
+                bs_trace_warning_line_time("Received group command %u, but groups are not enabled (-groups)\n", packet->header.command);
+            } else if (packet->header.command == DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP) {
+                channel_dynamic_att_set_group_for_dev(&packet->payload.set_group_payload);
+                bs_trace_raw(8, "Moved device %u to group %u\n", packet->payload.set_group_payload.device, packet->payload.set_group_payload.group);
+            } else {
+                channel_dynamic_att_set_group_att(&packet->payload.set_group_att_payload);
+                bs_trace_raw(8, "Updated attenuation between group %u and %u\n", packet->payload.set_group_att_payload.group, packet->payload.set_group_att_payload.peer_group);
+            }
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_BIN:
+            channel_dynamic_att_set_bin_for_dev(&packet->payload.set_att_bin_payload);
+            bs_trace_raw(8, "Updated attenuation in %u frequency bins for connections between device %u and %u\n", packet->payload.set_att_bin_payload.count,
+                         packet->payload.set_att_bin_payload.device, packet->payload.set_att_bin_payload.peer_device);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ALL:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ONE:
+            if (!channel_dynamic_att_fading_is_enabled()) {
+                bs_trace_warning_line_time("Received fading command %u, but fading is not enabled (-fading)\n", packet->header.command);
+            } else if (packet->header.command == DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ALL) {
+                channel_dynamic_att_set_fading_all_for_dev(&packet->payload.set_fading_all_payload);
+                bs_trace_raw(8, "Updated fading for all connections with device %u\n", packet->payload.set_fading_all_payload.device);
+            } else {
+                channel_dynamic_att_set_fading_one_for_dev(&packet->payload.set_fading_one_payload);
+                bs_trace_raw(8, "Updated fading for connections between device %u and %u\n", packet->payload.set_fading_one_payload.device,
+                             packet->payload.set_fading_one_payload.peer_device);
+            }
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_POS:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_OFFSET:
+            if (!channel_dynamic_att_position_is_enabled()) {
+                bs_trace_warning_line_time("Received position command %u, but no path loss model is enabled (-pathloss)\n", packet->header.command);
+            } else if (packet->header.command == DYNAMIC_ATT_PROTOCOL_CMD_SET_POS) {
+                channel_dynamic_att_set_position_for_dev(&packet->payload.set_position_payload);
+                bs_trace_raw(8, "Moved device %u\n", packet->payload.set_position_payload.device);
+            } else {
+                channel_dynamic_att_set_offset_for_dev(&packet->payload.set_offset_payload);
+                bs_trace_raw(8, "Updated attenuation offset of device %u\n", packet->payload.set_offset_payload.device);
+            }
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_RAMP:
+            channel_dynamic_att_ramp_for_dev(&packet->payload.ramp_payload);
+            bs_trace_raw(8, "Started attenuation ramp for connections between device %u and %u\n", packet->payload.ramp_payload.device,
+                         packet->payload.ramp_payload.peer_device);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_BEGIN:
+            channel_dynamic_att_begin_for_dev(&packet->payload.txn_payload);
+            bs_trace_raw(8, "Device %u began a transaction\n", packet->payload.txn_payload.device);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_COMMIT:
+            bs_trace_raw(8, "Device %u committed its transaction\n", packet->payload.txn_payload.device);
+            channel_dynamic_att_commit_for_dev(&packet->payload.txn_payload);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_ACK:
+            channel_dynamic_att_ack_for_dev(&packet->payload.ack_payload);
+            bs_trace_raw(8, "Acknowledged commands of device %u up to ack %u\n", packet->payload.ack_payload.device, packet->payload.ack_payload.sequence);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT:
+            channel_dynamic_att_snapshot_save((const char *)&packet->payload, ch_dynamic_att_prv.num_devices, ch_dynamic_att_prv.default_attenuation,
+                                              ch_dynamic_att_prv.now);
+            break;
+        case DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME:
+            at_time = (const ch_dynamic_att_com_protocol_at_time_t *)&packet->payload;
+            channel_dynamic_att_sched_add(at_time->apply_time, (const ch_dynamic_att_com_protocol_packet_t *)at_time->packet);
+            bs_trace_raw(8, "Scheduled command %u at %"PRItime"\n",
+                         ((const ch_dynamic_att_com_protocol_packet_t *)at_time->packet)->header.command, (bs_time_t)at_time->apply_time);
+            break;
+        default:
+            bs_trace_warning_line_time("Received unknown command %u\n", packet->header.command);
+    }
+}
+
+/*
+ * Drain the fifo and apply every complete command received so far (or when replaying, every
+ * journal command recorded up to <now>), followed by every scheduled command which is due at <now>.
+ * Ramps which have ended are then folded into the attenuation matrix.
+ */
+static void channel_dynamic_att_check(bs_time_t now)
+{
+    const ch_dynamic_att_com_protocol_packet_t *packet;
+    bs_time_t apply_time;
+    double attenuation;
+    uint tx, rx;
+
+    ch_dynamic_att_prv.now = now;
+    ch_dynamic_att_prv.next_check = now + ch_dynamic_att_prv.check_interval;
+    if (channel_dynamic_att_journal_is_replaying()) {
+        while ((packet = channel_dynamic_att_journal_replay_next(now)) != NULL) {
+            channel_dynamic_att_apply(packet);
+        }
+    } else {
+        channel_dynamic_att_com_poll();
+        while ((packet = channel_dynamic_att_com_next_packet()) != NULL) {
+            channel_dynamic_att_apply(packet);
+        }
+    }
+    while ((packet = channel_dynamic_att_sched_next(now, &apply_time)) != NULL) {
+        channel_dynamic_att_stats_lateness(now - apply_time);
+        channel_dynamic_att_apply(packet);
+    }
+    while (channel_dynamic_att_ramp_next_done(now, &tx, &rx, &attenuation)) {
+        channel_dynamic_att_set_link(tx, rx, attenuation);
+    }
+}
+
+/*
+ * Frequency bin of a transmission, from its center frequency (MHz above 2400 MHz, 8.8 fixed point).
+ * Frequencies outside the band go to the first or last bin.
+ */
+static uint channel_dynamic_att_freq_bin(int center_freq)
+{
+    uint bin;
+
+    if (center_freq <= 0) {
+        return 0U;
+    }
+    bin = ((uint)center_freq*ch_dynamic_att_prv.num_freq_bins)/(DYNAMIC_ATT_FREQ_BAND_WIDTH << 8);
+    return (bin < ch_dynamic_att_prv.num_freq_bins) ? bin : ch_dynamic_att_prv.num_freq_bins - 1U;
+}
+
+/*
+ * Copy the attenuation from every active transmitter to rx, in the frequency bin it transmits in
+ */
+static void channel_dynamic_att_gather_bins(uint rx, const uint *tx_used, const tx_el_t *tx_list, double *att)
+{
+    const double *row = channel_dynamic_att_matrix_bin_row(rx);
+    uint num_bins = ch_dynamic_att_prv.num_freq_bins;
+
+    for (uint tx = 0U; tx < ch_dynamic_att_prv.num_devices; tx++) {
+        if (tx_used[tx]) {
+            att[tx] = row[(size_t)tx*num_bins + channel_dynamic_att_freq_bin(tx_list[tx].tx_s.radio_params.center_freq)];
         }
     }
 }
 
+/*
+ * Attenuation lookup when only the matrix and ramps are in use, the common case
+ */
+static void channel_dynamic_att_lookup_matrix(const uint *tx_used, const tx_el_t *tx_list, uint rx, bs_time_t now, double *att)
+{
+    (void)tx_list;
+    channel_dynamic_att_matrix_gather(rx, tx_used, att);
+    if (channel_dynamic_att_ramp_count()) {
+        channel_dynamic_att_ramp_gather(rx, tx_used, now, att);
+    }
+}
+
+/*
+ * Attenuation lookup with positions, frequency bins, a timeline or fading
+ */
+static void channel_dynamic_att_lookup_full(const uint *tx_used, const tx_el_t *tx_list, uint rx, bs_time_t now, double *att)
+{
+    if (channel_dynamic_att_position_is_enabled()) {
+        channel_dynamic_att_position_refresh(rx);
+    }
+    if (ch_dynamic_att_prv.num_freq_bins > 1U) {
+        channel_dynamic_att_gather_bins(rx, tx_used, tx_list, att);
+    } else {
+        channel_dynamic_att_matrix_gather(rx, tx_used, att);
+    }
+    if (channel_dynamic_att_ramp_count()) {
+        channel_dynamic_att_ramp_gather(rx, tx_used, now, att);
+    }
+    if (channel_dynamic_att_timeline_is_open()) {
+        channel_dynamic_att_timeline_gather(rx, tx_used, now, att);
+    }
+    if (channel_dynamic_att_fading_is_enabled()) {
+        channel_dynamic_att_fading_apply(rx, tx_used, now, att);
+    }
+}
+
 /*
  * Public API
  */
@@ -118,7 +589,8 @@ static void channel_dynamic_att_check(void)
 /**
  * @brief Initialize this channel
  *
- * Allocate attenuation matrix and open fifo for receiving commands.
+ * Allocate attenuation matrix, load the initial snapshot and map the attenuation timeline if any, open fifo for receiving commands
+ * and map the statistics page. When replaying a journal the fifo and statistics page are not opened.
  */
 int channel_init(int argc, char *argv[], uint num_devices)
 {
@@ -128,14 +600,49 @@ int channel_init(int argc, char *argv[], uint num_devices)
 
     ch_dynamic_att_prv.default_attenuation = args.default_attenuation;
     ch_dynamic_att_prv.num_devices = num_devices;
+    ch_dynamic_att_prv.num_freq_bins = args.num_freq_bins;
+    /* A replayed journal must be applied at the recorded times */
+    ch_dynamic_att_prv.check_interval = args.replay_file ? 0U : args.check_interval;
+    ch_dynamic_att_prv.next_check = 0U;
 
-    ch_dynamic_att_prv.attenuation_matrix = bs_calloc(num_devices*num_devices, sizeof(double));
-    if (!ch_dynamic_att_prv.attenuation_matrix) {
-        bs_trace_error("Error allocating memory for attenuation matrix");
+    channel_dynamic_att_matrix_init(num_devices, args.default_attenuation, args.storage, args.num_groups, args.num_freq_bins);
+    channel_dynamic_att_txn_init(num_devices);
+    if (args.snapshot_file) {
+        channel_dynamic_att_snapshot_load(args.snapshot_file, num_devices);
+    }
+    if (args.timeline_file) {
+        channel_dynamic_att_timeline_open(args.timeline_file, num_devices);
+    }
+    if (args.pathloss != DYNAMIC_ATT_PATHLOSS_NONE) {
+        channel_dynamic_att_position_init(num_devices, args.pathloss, args.pathloss_exponent, args.pathloss_d0, args.pathloss_loss0);
+    }
+    if (args.fading != DYNAMIC_ATT_FADING_NONE) {
+        channel_dynamic_att_fading_init(num_devices, args.fading, args.fading_sigma, args.fading_seed, args.fading_coherence_time);
     }
-    channel_dynamic_att_reset_matrix();
 
-    channel_dynamic_att_com_open(args.sim_id, args.fifo_name);
+    /* The overlays are fixed from here on, so pick the lookup which skips the unused ones */
+    if (channel_dynamic_att_position_is_enabled() || args.num_freq_bins > 1U || channel_dynamic_att_timeline_is_open() ||
+        channel_dynamic_att_fading_is_enabled()) {
+        ch_dynamic_att_prv.lookup = channel_dynamic_att_lookup_full;
+    } else {
+        ch_dynamic_att_prv.lookup = channel_dynamic_att_lookup_matrix;
+    }
+
+    if (args.inner_channel) {
+        channel_dynamic_att_inner_open(args.inner_channel, args.inner_argc, args.inner_argv, num_devices);
+    }
+
+    if (args.record_file) {
+        channel_dynamic_att_journal_record_open(args.record_file, num_devices);
+    }
+    if (args.replay_file) {
+        /* Commands only come from the journal, no fifo and no clients */
+        channel_dynamic_att_journal_replay_open(args.replay_file, num_devices);
+    } else {
+        channel_dynamic_att_com_open(args.sim_id, args.fifo_name, args.use_shm);
+        channel_dynamic_att_stats_open(args.fifo_name, num_devices);
+        channel_dynamic_att_ack_open(args.fifo_name, num_devices);
+    }
 
     return 0;
 }
@@ -151,31 +658,36 @@ int channel_init(int argc, char *argv[], uint num_devices)
  *                                           1: that tx is transmitting,
  *               e.g. {0,1,1,0}: devices 1 and 2 are transmitting, device 0 and 3 are not.
  *  tx_list    : array with all transmissions status (the channel can check here the modulation type of the transmitter if necessary)
- *               (ignored in this channel)
+ *               with frequency bins, used for looking up the bin of each transmitter's center frequency
  *  txnbr      : desired transmitter number (the channel will calculate the ISI only for the desired transmitter)
- *               (ignored in this channel)
+ *               (only passed on to the inner channel, if any)
  *  rxnbr      : device number which is receiving
  *               used for looking up the attenuation between the two devices
  *  now        : current time
- *               (ignored in this channel)
+ *               used for applying scheduled commands which are due, for evaluating
+ *               the attenuation timeline and as part of the key of the fading
  *  att        : array with n_devs elements. The channel will overwrite the element i
  *               with the average attenuation from path i to rxnbr (in dBm)
  *               The caller allocates this array
+ *               With an inner channel this is the sum of both channels' attenuation
  *  ISI_SNR    : The channel will return here an estimate of the SNR limit due to multipath
  *               caused ISI for the desired transmitter (in dBs)
- *               (This channel sets this value always to 100.0)
+ *               (This channel sets this value to 100.0, or to the inner channel's estimate)
  *
  * Returns < 0 on error.
  * 0 otherwise
  */
 int channel_calc(const uint *tx_used, tx_el_t *tx_list, uint txnbr, uint rxnbr, bs_time_t now, double *att, double *ISI_SNR)
 {
-    channel_dynamic_att_check();
+    ch_dynamic_att_stats->calc_calls++;
+    ch_dynamic_att_stats->now = now;
+    if (now >= ch_dynamic_att_prv.next_check || now >= channel_dynamic_att_sched_next_time()) {
+        channel_dynamic_att_check(now);
+    }
 
-    for (uint device = 0U; device < ch_dynamic_att_prv.num_devices; device++) {
-        if (tx_used[device]) {
-            att[device] = *channel_dynamic_att_get_att_ptr(device, rxnbr);
-        }
+    ch_dynamic_att_prv.lookup(tx_used, tx_list, rxnbr, now, att);
+    if (channel_dynamic_att_inner_is_open()) {
+        return channel_dynamic_att_inner_add(tx_used, tx_list, txnbr, rxnbr, now, att, ISI_SNR);
     }
     *ISI_SNR = 100;
 
@@ -191,8 +703,16 @@ int channel_calc(const uint *tx_used, tx_el_t *tx_list, uint txnbr, uint rxnbr,
 void channel_delete()
 {
     channel_dynamic_att_com_close();
+    channel_dynamic_att_stats_close();
+    channel_dynamic_att_ack_close();
+    channel_dynamic_att_journal_close();
+    channel_dynamic_att_sched_delete();
+    channel_dynamic_att_timeline_close();
+    channel_dynamic_att_fading_delete();
+    channel_dynamic_att_position_delete();
+    channel_dynamic_att_ramp_delete();
+    channel_dynamic_att_txn_delete();
+    channel_dynamic_att_inner_close();
 
-    if (ch_dynamic_att_prv.attenuation_matrix) {
-        free(ch_dynamic_att_prv.attenuation_matrix);
-    }
+    channel_dynamic_att_matrix_delete();
 }
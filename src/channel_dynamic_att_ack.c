@@ -0,0 +1,112 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+** Include this file before including system headers.  By default, with
+** C99 support from the compiler, it requests POSIX 2008 support.  With
+** C89 support only, it requests POSIX 1997 support.  Override the
+** default behaviour by setting either _XOPEN_SOURCE or _POSIX_C_SOURCE.
+*/
+/* _XOPEN_SOURCE 700 is loosely equivalent to _POSIX_C_SOURCE 200809L */
+/* _XOPEN_SOURCE 600 is loosely equivalent to _POSIX_C_SOURCE 200112L */
+/* _XOPEN_SOURCE 500 is loosely equivalent to _POSIX_C_SOURCE 199506L */
+#if !defined(_XOPEN_SOURCE) && !defined(_POSIX_C_SOURCE)
+#if defined(__cplusplus)
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#elif __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#else
+#define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
+#endif /* __STDC_VERSION__ */
+#endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "bs_oswrap.h"
+#include "bs_tracing.h"
+#include "channel_dynamic_att_ack.h"
+#include "channel_dynamic_att_ack_format.h"
+
+extern char *pb_com_path;
+
+static struct {
+    ch_dynamic_att_ack_header_t *page;
+    ch_dynamic_att_ack_entry_t  *entries;
+    size_t                       map_size;
+    char                        *path;
+} ch_dynamic_att_ack_prv = {0};
+
+void channel_dynamic_att_ack_open(const char *fifo_name, uint num_devices)
+{
+    char *path;
+    int fd;
+
+    path = bs_calloc(strlen(pb_com_path) + strlen(fifo_name) + strlen(DYNAMIC_ATT_ACK_SUFFIX) + 2, sizeof(char));
+    if (!path) {
+        bs_trace_error("Error allocating memory for ack page path");
+    }
+    sprintf(path, "%s/%s%s", pb_com_path, fifo_name, DYNAMIC_ATT_ACK_SUFFIX);
+    ch_dynamic_att_ack_prv.path = path;
+
+    ch_dynamic_att_ack_prv.map_size = sizeof(ch_dynamic_att_ack_header_t) + (size_t)num_devices*sizeof(ch_dynamic_att_ack_entry_t);
+    /*
+     * Create a new file instead of truncating an old one, which a client from an earlier run may
+     * still have mapped
+     */
+    remove(path);
+    fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0 || ftruncate(fd, ch_dynamic_att_ack_prv.map_size) != 0) {
+        /* Not fatal, only clients waiting for acks are affected */
+        bs_trace_warning_line("Failed creating ack page at location %s\n", path);
+    } else {
+        ch_dynamic_att_ack_prv.page = mmap(NULL, ch_dynamic_att_ack_prv.map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ch_dynamic_att_ack_prv.page == MAP_FAILED) {
+            ch_dynamic_att_ack_prv.page = NULL;
+            bs_trace_warning_line("Failed mapping ack page at location %s\n", path);
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    if (ch_dynamic_att_ack_prv.page) {
+        ch_dynamic_att_ack_prv.entries = (ch_dynamic_att_ack_entry_t *)(ch_dynamic_att_ack_prv.page + 1);
+        ch_dynamic_att_ack_prv.page->version = DYNAMIC_ATT_ACK_VERSION;
+        ch_dynamic_att_ack_prv.page->num_devices = num_devices;
+        __atomic_store_n(&ch_dynamic_att_ack_prv.page->magic, DYNAMIC_ATT_ACK_MAGIC, __ATOMIC_RELEASE);
+    }
+}
+
+void channel_dynamic_att_ack_close(void)
+{
+    if (ch_dynamic_att_ack_prv.page) {
+        munmap(ch_dynamic_att_ack_prv.page, ch_dynamic_att_ack_prv.map_size);
+    }
+    if (ch_dynamic_att_ack_prv.path) {
+        remove(ch_dynamic_att_ack_prv.path);
+        free(ch_dynamic_att_ack_prv.path);
+    }
+    memset(&ch_dynamic_att_ack_prv, 0, sizeof(ch_dynamic_att_ack_prv));
+}
+
+void channel_dynamic_att_ack_set(uint device, uint32_t sequence, bs_time_t now)
+{
+    ch_dynamic_att_ack_entry_t *entry;
+    uint32_t version;
+
+    if (!ch_dynamic_att_ack_prv.page) {
+        return;
+    }
+    entry = &ch_dynamic_att_ack_prv.entries[device];
+    version = entry->version;
+
+    __atomic_store_n(&entry->version, version + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&entry->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->apply_time, (uint64_t)now, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->version, version + 2U, __ATOMIC_RELEASE);
+}
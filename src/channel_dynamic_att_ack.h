@@ -0,0 +1,44 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_ACK_H
+#define _CHANNEL_DYNAMIC_ATT_ACK_H
+
+#include "bs_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create and map the ack page
+ *
+ * Must be called after the com folder has been created. A file left from an earlier run is
+ * replaced.
+ *
+ * @param fifo_name The logical name of the fifo, which the page is named after
+ * @param num_devices Number of devices in the simulation
+ */
+void channel_dynamic_att_ack_open(const char *fifo_name, uint num_devices);
+
+/**
+ * @brief Unmap and delete the ack page, if any
+ */
+void channel_dynamic_att_ack_close(void);
+
+/**
+ * @brief Publish that the CMD_ACK with this sequence number from device was applied
+ *
+ * @param device The device which sent the CMD_ACK
+ * @param sequence Its sequence number
+ * @param now Simulation time it was applied at
+ */
+void channel_dynamic_att_ack_set(uint device, uint32_t sequence, bs_time_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_ACK_H */
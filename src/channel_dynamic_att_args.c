@@ -3,12 +3,17 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include <string.h>
 #include "bs_cmd_line.h"
 #include "bs_tracing.h"
 #include "channel_dynamic_att_args.h"
 #include "channel_dynamic_att_defaults.h"
 
 static char library_name[] = "Dynamic attenautor 2G4 channel";
+static char *storage_name;
+static char *fading_name;
+static char *pathloss_name;
+static bool symmetric;
 
 void component_print_post_help()
 {
@@ -34,11 +39,83 @@ void channel_dynamic_att_argparse(int argc, char *argv[], ch_dynamic_att_args_t
          "Initial attenuation in dB, used in all NxN paths until changed."},
         {false, false, false,  "fn",    "fifo_name",     's',        (void *)&args->fifo_name,                 NULL,
          "Name of pipe for communication."                                },
+        {false, false, false,  "st",    "storage",       's',        (void *)&storage_name,                    NULL,
+         "Attenuation storage: auto (default), dense or sparse. Sparse only stores links set to a non default value."},
+        {false, false, false,  "tl",    "timeline",      's',        (void *)&args->timeline_file,             NULL,
+         "Binary file with attenuation breakpoints per link, interpolated over simulation time."},
+        {false, false, true,   "symmetric", "symmetric", 'b',    (void *)&symmetric,                       NULL,
+         "Store one attenuation per link for both directions, halving the matrix. Asymmetric commands are flagged."},
+        {false, false, true,   "shm",   "shm",           'b',        (void *)&args->use_shm,                   NULL,
+         "Receive commands through a shared memory ring instead of the fifo. Clients must use channel_dynamic_att_client_open_shm()."},
+        {false, false, false,  "groups", "groups",       'u',        (void *)&args->num_groups,                NULL,
+         "Number of device groups. Links follow a group to group attenuation unless set individually. Needs sparse storage."},
+        {false, false, false,  "snap",  "snapshot",      's',        (void *)&args->snapshot_file,             NULL,
+         "Snapshot file with the initial attenuation of all links, as saved by CMD_SNAPSHOT."},
+        {false, false, false,  "record", "record",       's',        (void *)&args->record_file,               NULL,
+         "Record every applied command with its simulation time to this journal file."},
+        {false, false, false,  "replay", "replay",       's',        (void *)&args->replay_file,               NULL,
+         "Replay the commands of this journal file at their recorded times. No fifo is opened and no clients are needed."},
+        {false, false, false,  "freq_bins", "freq_bins", 'u',        (void *)&args->num_freq_bins,             NULL,
+         "Number of frequency bins the 2.4 GHz band is split in, each with its own attenuation per link. Needs dense storage."},
+        {false, false, false,  "fading", "fading",       's',        (void *)&fading_name,                     NULL,
+         "Random fading added to the attenuation: none (default), gauss or rayleigh."},
+        {false, false, false,  "fading_sigma", "fading_sigma", 'f',  (void *)&args->fading_sigma,              NULL,
+         "Standard deviation in dB of the fading of links which have not been set by a client (default 0)."},
+        {false, false, false,  "fading_seed", "fading_seed", 'u',    (void *)&args->fading_seed,               NULL,
+         "Seed of the fading. The same seed gives the same fading in every run."},
+        {false, false, false,  "fading_coherence", "fading_coherence", 'u', (void *)&args->fading_coherence_time, NULL,
+         "Time in microseconds over which the fading of a link stays the same (default 1)."},
+        {false, false, false,  "pathloss", "pathloss",   's',        (void *)&pathloss_name,                   NULL,
+         "Compute the attenuation between devices with a position: none (default), fspl or logdist."},
+        {false, false, false,  "pl_exponent", "pl_exponent", 'f',    (void *)&args->pathloss_exponent,         NULL,
+         "Path loss exponent of the logdist model (default 2)."},
+        {false, false, false,  "pl_d0", "pl_d0",         'f',        (void *)&args->pathloss_d0,               NULL,
+         "Reference distance in meters of the path loss models (default 1)."},
+        {false, false, false,  "pl_loss0", "pl_loss0",   'f',        (void *)&args->pathloss_loss0,            NULL,
+         "Path loss in dB at the reference distance of the logdist model (default 40.2, free space at 1 m)."},
+        {false, false, false,  "check_interval", "check_interval", 'u', (void *)&args->check_interval,        NULL,
+         "Simulation time in microseconds between checks for new commands (default 0, every evaluation). Scheduled commands are still applied on time."},
+        {false, false, false,  "inner", "inner",         's',        (void *)&args->inner_channel,             NULL,
+         "Channel to add the attenuation of this channel to, e.g. Multipath, or a library path. Its arguments follow -argsinner."},
         ARG_TABLE_ENDMARKER
     };
 
     args->default_attenuation = DYNAMIC_ATT_DEFAULT;
     args->fifo_name           = DYNAMIC_ATT_DEFAULT_FIFO_NAME;
+    args->storage             = DYNAMIC_ATT_STORAGE_AUTO;
+    args->timeline_file       = NULL;
+    args->use_shm             = false;
+    args->num_groups          = 0U;
+    args->snapshot_file       = NULL;
+    args->record_file         = NULL;
+    args->replay_file         = NULL;
+    args->num_freq_bins       = 1U;
+    args->fading              = DYNAMIC_ATT_FADING_NONE;
+    args->fading_sigma        = 0.0;
+    args->fading_seed         = 0U;
+    args->fading_coherence_time = 1U;
+    args->pathloss            = DYNAMIC_ATT_PATHLOSS_NONE;
+    args->pathloss_exponent   = 2.0;
+    args->pathloss_d0         = 1.0;
+    args->pathloss_loss0      = 40.2;
+    args->check_interval      = 0U;
+    args->inner_channel       = NULL;
+    args->inner_argc          = 0;
+    args->inner_argv          = NULL;
+    storage_name              = NULL;
+    fading_name               = NULL;
+    pathloss_name             = NULL;
+    symmetric                 = false;
+
+    /* Everything after -argsinner belongs to the inner channel */
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "-argsinner")) {
+            args->inner_argc = argc - i - 1;
+            args->inner_argv = &argv[i + 1];
+            argc = i;
+            break;
+        }
+    }
 
     bs_args_override_exe_name(library_name);
     bs_args_set_trace_prefix("channel: (dynamic_att) ");
@@ -49,4 +126,67 @@ void channel_dynamic_att_argparse(int argc, char *argv[], ch_dynamic_att_args_t
         bs_trace_error("channel: cmdarg: attenuation must be be between %lf dBm and %lf dBm (is %lf)\n",
                        DYNAMIC_ATT_MIN, DYNAMIC_ATT_MAX, args->default_attenuation);
     }
+
+    if (args->num_groups > DYNAMIC_ATT_MAX_GROUPS) {
+        bs_trace_error("channel: cmdarg: groups must be at most %u (is %u)\n", DYNAMIC_ATT_MAX_GROUPS, args->num_groups);
+    }
+
+    if (args->num_freq_bins < 1U || args->num_freq_bins > DYNAMIC_ATT_MAX_FREQ_BINS) {
+        bs_trace_error("channel: cmdarg: freq_bins must be between 1 and %u (is %u)\n", DYNAMIC_ATT_MAX_FREQ_BINS, args->num_freq_bins);
+    }
+
+    if (storage_name) {
+        if (!strcmp(storage_name, "auto")) {
+            args->storage = DYNAMIC_ATT_STORAGE_AUTO;
+        } else if (!strcmp(storage_name, "dense")) {
+            args->storage = DYNAMIC_ATT_STORAGE_DENSE;
+        } else if (!strcmp(storage_name, "sparse")) {
+            args->storage = DYNAMIC_ATT_STORAGE_SPARSE;
+        } else {
+            bs_trace_error("channel: cmdarg: storage must be auto, dense or sparse (is %s)\n", storage_name);
+        }
+    }
+
+    if (args->inner_argc && !args->inner_channel) {
+        bs_trace_error("channel: cmdarg: -argsinner given without an inner channel (-inner)\n");
+    }
+
+    if (symmetric) {
+        if (args->storage == DYNAMIC_ATT_STORAGE_SPARSE || args->storage == DYNAMIC_ATT_STORAGE_DENSE) {
+            bs_trace_error("channel: cmdarg: symmetric is a storage of its own, it cannot be used with -st=%s\n", storage_name);
+        }
+        args->storage = DYNAMIC_ATT_STORAGE_SYMMETRIC;
+    }
+
+    if (fading_name) {
+        if (!strcmp(fading_name, "none")) {
+            args->fading = DYNAMIC_ATT_FADING_NONE;
+        } else if (!strcmp(fading_name, "gauss")) {
+            args->fading = DYNAMIC_ATT_FADING_GAUSS;
+        } else if (!strcmp(fading_name, "rayleigh")) {
+            args->fading = DYNAMIC_ATT_FADING_RAYLEIGH;
+        } else {
+            bs_trace_error("channel: cmdarg: fading must be none, gauss or rayleigh (is %s)\n", fading_name);
+        }
+    }
+
+    if (pathloss_name) {
+        if (!strcmp(pathloss_name, "none")) {
+            args->pathloss = DYNAMIC_ATT_PATHLOSS_NONE;
+        } else if (!strcmp(pathloss_name, "fspl")) {
+            args->pathloss = DYNAMIC_ATT_PATHLOSS_FSPL;
+        } else if (!strcmp(pathloss_name, "logdist")) {
+            args->pathloss = DYNAMIC_ATT_PATHLOSS_LOGDIST;
+        } else {
+            bs_trace_error("channel: cmdarg: pathloss must be none, fspl or logdist (is %s)\n", pathloss_name);
+        }
+    }
+
+    if (args->pathloss_d0 <= 0.0) {
+        bs_trace_error("channel: cmdarg: pl_d0 must be positive (is %lf)\n", args->pathloss_d0);
+    }
+
+    if (args->fading_sigma < 0.0 || args->fading_coherence_time < 1U) {
+        bs_trace_error("channel: cmdarg: fading_sigma must not be negative and fading_coherence must be at least 1\n");
+    }
 }
@@ -6,14 +6,38 @@
 #ifndef _CHANNEL_DYNAMIC_ATT_ARGS_H
 #define _CHANNEL_DYNAMIC_ATT_ARGS_H
 
+#include "channel_dynamic_att_fading.h"
+#include "channel_dynamic_att_matrix.h"
+#include "channel_dynamic_att_position.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct {
-    char   *sim_id;
-    double  default_attenuation;
-    char   *fifo_name;
+    char                    *sim_id;
+    double                   default_attenuation;
+    char                    *fifo_name;
+    ch_dynamic_att_storage_t storage;
+    char                    *timeline_file;
+    bool                     use_shm;
+    uint                     num_groups;
+    char                    *snapshot_file;
+    char                    *record_file;
+    char                    *replay_file;
+    uint                     num_freq_bins;
+    ch_dynamic_att_fading_t  fading;
+    double                   fading_sigma;
+    uint                     fading_seed;
+    uint                     fading_coherence_time;
+    ch_dynamic_att_pathloss_t pathloss;
+    double                   pathloss_exponent;
+    double                   pathloss_d0;
+    double                   pathloss_loss0;
+    uint                     check_interval;
+    char                    *inner_channel;
+    int                      inner_argc;
+    char                   **inner_argv;
 } ch_dynamic_att_args_t;
 
 /**
@@ -23,6 +47,27 @@ typedef struct {
  *   's' or 'sim_id',        mandatory: The current BSIM ID for the simulation
  *   'att' or 'attenuation', optional : The default attenuation between all devices
  *   'fn' or 'fifo_name',    optional : The name of the fifo used for receiving commands from client
+ *   'st' or 'storage',      optional : Attenuation storage mode: auto, dense or sparse
+ *   'symmetric',            optional : Store one attenuation per link for both directions (packed upper triangle)
+ *   'tl' or 'timeline',     optional : File with per link attenuation timelines
+ *   'shm',                  optional : Receive commands through shared memory instead of the fifo
+ *   'groups',               optional : Number of device groups, 0 (default) for no groups
+ *   'snap' or 'snapshot',   optional : Snapshot file with the initial attenuation of all links
+ *   'record',               optional : Journal file to record applied commands to
+ *   'replay',               optional : Journal file to replay commands from, instead of the fifo
+ *   'freq_bins',            optional : Number of frequency bins with their own attenuation, 1 (default) for none
+ *   'fading',               optional : Fading overlay: none (default), gauss or rayleigh
+ *   'fading_sigma',         optional : Default fading standard deviation in dB
+ *   'fading_seed',          optional : Seed of the fading random numbers
+ *   'fading_coherence',     optional : Time in microseconds over which the fading of a link stays the same
+ *   'pathloss',             optional : Path loss model for devices with a position: none (default), fspl or logdist
+ *   'pl_exponent',          optional : Path loss exponent of the logdist model
+ *   'pl_d0',                optional : Reference distance in meters of the path loss models
+ *   'pl_loss0',             optional : Path loss in dB at the reference distance of the logdist model
+ *   'check_interval',       optional : Simulation time in microseconds between checks for new commands, 0 (default) for every evaluation
+ *   'inner',                optional : Channel to layer this channel on top of, by name or library path
+ *
+ * All arguments after '-argsinner' are not parsed, but passed on to the inner channel.
 */
 void channel_dynamic_att_argparse(int argc, char *argv[], ch_dynamic_att_args_t *args);
 
@@ -21,20 +21,35 @@
 #define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
 #endif /* __STDC_VERSION__ */
 #endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <stddef.h>
 #include <string.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "bs_oswrap.h"
 #include "bs_types.h"
 #include "bs_tracing.h"
 #include "bs_pc_base.h"
 #include "channel_dynamic_att_com.h"
 #include "channel_dynamic_att_com_protocol.h"
+#include "channel_dynamic_att_shm_ring.h"
+#include "channel_dynamic_att_stats.h"
 
 extern char *pb_com_path;
 
+/* Large enough to drain a full default sized pipe in one read */
+#define DYNAMIC_ATT_COM_BUFFER_SIZE (64*1024)
+
 static struct {
-    char *fifo_full_path;
-    int   fifo_read_handle;
+    char          *fifo_full_path;
+    int            fifo_read_handle;
+    unsigned char *buffer;
+    size_t         buffer_head;
+    size_t         buffer_tail;
+    bool           in_sync;
+    char                      *ring_full_path;
+    ch_dynamic_att_shm_ring_t *ring;
+    size_t                     ring_map_size;
 } ch_dynamic_att_com_prv = {0};
 
 static void channel_dynamic_att_com_prepare(char *sim_id, char *fifo_name)
@@ -52,18 +67,86 @@ static void channel_dynamic_att_com_prepare(char *sim_id, char *fifo_name)
     sprintf(ch_dynamic_att_com_prv.fifo_full_path, "%s/%s", pb_com_path, fifo_name);
 }
 
-void channel_dynamic_att_com_open(char *sim_id, char *fifo_name)
+static void channel_dynamic_att_com_open_fifo(void)
+{
+    if (pb_create_fifo_if_not_there(ch_dynamic_att_com_prv.fifo_full_path) != 0) {
+        bs_trace_error("Failed creating fifo at location %s\n", ch_dynamic_att_com_prv.fifo_full_path);
+    }
+    ch_dynamic_att_com_prv.fifo_read_handle = open(ch_dynamic_att_com_prv.fifo_full_path, O_RDONLY | O_NONBLOCK);
+    if (ch_dynamic_att_com_prv.fifo_read_handle < 0) {
+        bs_trace_error("Failed opening fifo at location %s: %d\n", ch_dynamic_att_com_prv.fifo_full_path, ch_dynamic_att_com_prv.fifo_read_handle);
+    }
+    bs_trace_raw(8, "channel_dynamic_att opened fifo\n");
+}
+
+/*
+ * Clear the magic of a ring file, so no client starts using it, before the file is removed
+ */
+static void channel_dynamic_att_com_retire_ring(const char *path)
+{
+    ch_dynamic_att_shm_ring_t *ring;
+    int fd;
+
+    fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return;
+    }
+    ring = mmap(NULL, sizeof(ch_dynamic_att_shm_ring_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring != MAP_FAILED) {
+        __atomic_store_n(&ring->magic, 0U, __ATOMIC_RELEASE);
+        munmap(ring, sizeof(ch_dynamic_att_shm_ring_t));
+    }
+}
+
+static void channel_dynamic_att_com_open_ring(void)
+{
+    int fd;
+
+    ch_dynamic_att_com_prv.ring_full_path = bs_calloc(strlen(ch_dynamic_att_com_prv.fifo_full_path) + strlen(DYNAMIC_ATT_SHM_RING_SUFFIX) + 1, sizeof(char));
+    if (!ch_dynamic_att_com_prv.ring_full_path) {
+        bs_trace_error("Error allocating memory for shared memory path");
+    }
+    sprintf(ch_dynamic_att_com_prv.ring_full_path, "%s%s", ch_dynamic_att_com_prv.fifo_full_path, DYNAMIC_ATT_SHM_RING_SUFFIX);
+
+    /* Start from an empty file so no stale data from an earlier run is left in the ring */
+    channel_dynamic_att_com_retire_ring(ch_dynamic_att_com_prv.ring_full_path);
+    remove(ch_dynamic_att_com_prv.ring_full_path);
+    fd = open(ch_dynamic_att_com_prv.ring_full_path, O_RDWR | O_CREAT | O_EXCL, 0666);
+    ch_dynamic_att_com_prv.ring_map_size = sizeof(ch_dynamic_att_shm_ring_t) + DYNAMIC_ATT_SHM_RING_SIZE;
+    if (fd < 0 || ftruncate(fd, ch_dynamic_att_com_prv.ring_map_size) != 0) {
+        bs_trace_error("Failed creating shared memory at location %s\n", ch_dynamic_att_com_prv.ring_full_path);
+    }
+    ch_dynamic_att_com_prv.ring = mmap(NULL, ch_dynamic_att_com_prv.ring_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ch_dynamic_att_com_prv.ring == MAP_FAILED) {
+        ch_dynamic_att_com_prv.ring = NULL;
+        bs_trace_error("Failed mapping shared memory at location %s\n", ch_dynamic_att_com_prv.ring_full_path);
+    }
+
+    ch_dynamic_att_com_prv.ring->size = DYNAMIC_ATT_SHM_RING_SIZE;
+    ch_dynamic_att_com_prv.ring->owner_pid = (uint32_t)getpid();
+    __atomic_store_n(&ch_dynamic_att_com_prv.ring->magic, DYNAMIC_ATT_SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    bs_trace_raw(8, "channel_dynamic_att opened shared memory ring\n");
+}
+
+void channel_dynamic_att_com_open(char *sim_id, char *fifo_name, bool use_shm)
 {
     if (!ch_dynamic_att_com_prv.fifo_full_path) {
         channel_dynamic_att_com_prepare(sim_id, fifo_name);
-        if (pb_create_fifo_if_not_there(ch_dynamic_att_com_prv.fifo_full_path) != 0) {
-            bs_trace_error("Failed creating fifo at location %s\n", ch_dynamic_att_com_prv.fifo_full_path);
+        ch_dynamic_att_com_prv.fifo_read_handle = -1;
+        if (use_shm) {
+            channel_dynamic_att_com_open_ring();
+        } else {
+            channel_dynamic_att_com_open_fifo();
         }
-        ch_dynamic_att_com_prv.fifo_read_handle = open(ch_dynamic_att_com_prv.fifo_full_path, O_RDONLY | O_NONBLOCK);
-        if (ch_dynamic_att_com_prv.fifo_read_handle < 0) {
-            bs_trace_error("Failed opening fifo at location %s: %d\n", ch_dynamic_att_com_prv.fifo_full_path, ch_dynamic_att_com_prv.fifo_read_handle);
+        ch_dynamic_att_com_prv.buffer = bs_calloc(DYNAMIC_ATT_COM_BUFFER_SIZE, sizeof(unsigned char));
+        if (!ch_dynamic_att_com_prv.buffer) {
+            bs_trace_error("Error allocating memory for fifo buffer");
         }
-        bs_trace_raw(8, "channel_dynamic_att opened fifo\n");
+        ch_dynamic_att_com_prv.buffer_head = 0;
+        ch_dynamic_att_com_prv.buffer_tail = 0;
+        ch_dynamic_att_com_prv.in_sync = true;
     }
 }
 
@@ -72,64 +155,239 @@ void channel_dynamic_att_com_close(void)
     if (ch_dynamic_att_com_prv.fifo_full_path) {
         if (ch_dynamic_att_com_prv.fifo_read_handle >= 0) {
             close(ch_dynamic_att_com_prv.fifo_read_handle);
+            remove(ch_dynamic_att_com_prv.fifo_full_path);
+        }
+        if (ch_dynamic_att_com_prv.ring) {
+            __atomic_store_n(&ch_dynamic_att_com_prv.ring->magic, 0U, __ATOMIC_RELEASE);
+            munmap(ch_dynamic_att_com_prv.ring, ch_dynamic_att_com_prv.ring_map_size);
+            ch_dynamic_att_com_prv.ring = NULL;
+            remove(ch_dynamic_att_com_prv.ring_full_path);
+            free(ch_dynamic_att_com_prv.ring_full_path);
+            ch_dynamic_att_com_prv.ring_full_path = NULL;
+        }
+
+        if (ch_dynamic_att_com_prv.buffer) {
+            free(ch_dynamic_att_com_prv.buffer);
+            ch_dynamic_att_com_prv.buffer = NULL;
         }
 
-        remove(ch_dynamic_att_com_prv.fifo_full_path);
         free(ch_dynamic_att_com_prv.fifo_full_path);
         ch_dynamic_att_com_prv.fifo_full_path = NULL;
     }
 }
 
-static bool channel_dynamic_att_com_read(size_t data_size, void *destination)
+/*
+ * Move the unparsed bytes to the start of the buffer, so the next read can use all the free space.
+ */
+static void channel_dynamic_att_com_compact(void)
+{
+    size_t pending = ch_dynamic_att_com_prv.buffer_tail - ch_dynamic_att_com_prv.buffer_head;
+
+    if (ch_dynamic_att_com_prv.buffer_head > 0) {
+        memmove(ch_dynamic_att_com_prv.buffer, ch_dynamic_att_com_prv.buffer + ch_dynamic_att_com_prv.buffer_head, pending);
+        ch_dynamic_att_com_prv.buffer_head = 0;
+        ch_dynamic_att_com_prv.buffer_tail = pending;
+    }
+}
+
+/*
+ * Move every published record from the shared memory ring into the receive buffer, as long as
+ * there is room for it
+ */
+static size_t channel_dynamic_att_com_poll_ring(size_t free_space)
+{
+    ch_dynamic_att_shm_ring_t *ring = ch_dynamic_att_com_prv.ring;
+    uint64_t read_pos = ring->read_pos;
+    size_t bytes_read = 0;
+
+    for (;;) {
+        unsigned char *record_data = ring->data + (read_pos & (ring->size - 1U));
+        ch_dynamic_att_shm_ring_record_t *record = (ch_dynamic_att_shm_ring_record_t *)record_data;
+        uint32_t length = __atomic_load_n(&record->length, __ATOMIC_ACQUIRE);
+
+        if (length == 0U) {
+            break;
+        }
+        if (!(length & DYNAMIC_ATT_SHM_RING_PAD_FLAG)) {
+            if (record->packet_size > free_space - bytes_read) {
+                break;
+            }
+            memcpy(ch_dynamic_att_com_prv.buffer + ch_dynamic_att_com_prv.buffer_tail + bytes_read, record + 1, record->packet_size);
+            bytes_read += record->packet_size;
+        }
+        length &= ~DYNAMIC_ATT_SHM_RING_PAD_FLAG;
+        /* Producers expect free space to read as zero */
+        memset(record_data, 0, length);
+        read_pos += length;
+    }
+
+    if (bytes_read || read_pos != ring->read_pos) {
+        __atomic_store_n(&ring->read_pos, read_pos, __ATOMIC_RELEASE);
+    }
+    return bytes_read;
+}
+
+size_t channel_dynamic_att_com_poll(void)
 {
     ssize_t bytes_read;
+    size_t  free_space;
+
+    if (!ch_dynamic_att_com_prv.buffer) {
+        return 0;
+    }
+
+    channel_dynamic_att_com_compact();
+    free_space = DYNAMIC_ATT_COM_BUFFER_SIZE - ch_dynamic_att_com_prv.buffer_tail;
+    if (free_space == 0) {
+        return 0;
+    }
 
-    bytes_read = read(ch_dynamic_att_com_prv.fifo_read_handle, destination, data_size);
-    if (bytes_read > 0) {
-        bs_trace_raw(8, "channel_dynamic_att_com_read: Received %d bytes\n", bytes_read);
+    ch_dynamic_att_stats->polls++;
+    if (ch_dynamic_att_com_prv.ring) {
+        bytes_read = channel_dynamic_att_com_poll_ring(free_space);
+    } else {
+        bytes_read = read(ch_dynamic_att_com_prv.fifo_read_handle, ch_dynamic_att_com_prv.buffer + ch_dynamic_att_com_prv.buffer_tail, free_space);
+    }
+    if (bytes_read <= 0) {
+        ch_dynamic_att_stats->empty_polls++;
+        return 0;
     }
 
-    return bytes_read == data_size;
+    bs_trace_raw(8, "channel_dynamic_att_com_poll: Received %zd bytes\n", bytes_read);
+    ch_dynamic_att_stats->bytes_read += bytes_read;
+    ch_dynamic_att_com_prv.buffer_tail += bytes_read;
+
+    return bytes_read;
 }
 
-static bool channel_dynamic_att_com_read_cmd_data_set_att_all(ch_dynamic_att_com_protocol_packet_t *packet)
+/*
+ * Check that the header describes a command we know, with the payload size that command requires.
+ */
+static bool channel_dynamic_att_com_header_is_valid(const ch_dynamic_att_com_protocol_header_t *header)
 {
-    if (packet->header.payload_size == sizeof(ch_dynamic_att_com_protocol_set_att_all_t)) {
-        return channel_dynamic_att_com_read(sizeof(ch_dynamic_att_com_protocol_set_att_all_t), &packet->payload.set_att_all_payload);
+    if (sizeof(*header) + header->payload_size > DYNAMIC_ATT_COM_BUFFER_SIZE) {
+        return false;
+    }
+
+    switch (header->command) {
+        case DYNAMIC_ATT_PROTOCOL_CMD_RESET:
+            return header->payload_size == 0 || header->payload_size == sizeof(ch_dynamic_att_com_protocol_reset_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_att_all_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_att_one_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_RX:
+            return header->payload_size >= sizeof(ch_dynamic_att_com_protocol_set_att_vector_t) &&
+                   (header->payload_size - sizeof(ch_dynamic_att_com_protocol_set_att_vector_t)) % sizeof(double) == 0;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_LST:
+            return header->payload_size >= sizeof(ch_dynamic_att_com_protocol_set_att_list_t) &&
+                   (header->payload_size - sizeof(ch_dynamic_att_com_protocol_set_att_list_t)) % sizeof(ch_dynamic_att_com_protocol_link_t) == 0;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_group_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_GRP_ATT:
+            /* The device number at the end is optional */
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_group_att_t) ||
+                   header->payload_size == offsetof(ch_dynamic_att_com_protocol_set_group_att_t, device);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT:
+            return header->payload_size >= 2;
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_BIN:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_att_bin_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ALL:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_fading_all_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_FAD_ONE:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_fading_one_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_POS:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_position_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_OFFSET:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_set_offset_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_RAMP:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_ramp_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_BEGIN:
+        case DYNAMIC_ATT_PROTOCOL_CMD_COMMIT:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_txn_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_ACK:
+            return header->payload_size == sizeof(ch_dynamic_att_com_protocol_ack_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME:
+            return header->payload_size >= sizeof(ch_dynamic_att_com_protocol_at_time_t) + sizeof(ch_dynamic_att_com_protocol_header_t);
+        default:
+            return false;
     }
-    bs_trace_error("Failed to read DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL data. Got %u bytes, but expected %u bytes\n", packet->header.payload_size, sizeof(ch_dynamic_att_com_protocol_set_att_all_t));
-    return false;
 }
 
-static bool channel_dynamic_att_com_read_cmd_data_set_att_one(ch_dynamic_att_com_protocol_packet_t *packet)
+/*
+ * Check that the counts inside a variable sized payload agree with the payload size from the header
+ */
+static bool channel_dynamic_att_com_payload_is_valid(const ch_dynamic_att_com_protocol_packet_t *packet)
 {
-    if (packet->header.payload_size == sizeof(ch_dynamic_att_com_protocol_set_att_one_t)) {
-        return channel_dynamic_att_com_read(sizeof(ch_dynamic_att_com_protocol_set_att_one_t), &packet->payload.set_att_one_payload);
+    const ch_dynamic_att_com_protocol_set_att_vector_t *vector;
+    const ch_dynamic_att_com_protocol_set_att_list_t *list;
+    const ch_dynamic_att_com_protocol_at_time_t *at_time;
+    const ch_dynamic_att_com_protocol_packet_t *wrapped;
+
+    switch (packet->header.command) {
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_TX:
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_RX:
+            vector = (const ch_dynamic_att_com_protocol_set_att_vector_t *)&packet->payload;
+            return packet->header.payload_size == sizeof(*vector) + vector->count*sizeof(double);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_LST:
+            list = (const ch_dynamic_att_com_protocol_set_att_list_t *)&packet->payload;
+            return packet->header.payload_size == sizeof(*list) + list->count*sizeof(ch_dynamic_att_com_protocol_link_t);
+        case DYNAMIC_ATT_PROTOCOL_CMD_SNAPSHOT:
+            /* The file name must be zero terminated */
+            return ((const char *)&packet->payload)[packet->header.payload_size - 1] == '\0';
+        case DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME:
+            at_time = (const ch_dynamic_att_com_protocol_at_time_t *)&packet->payload;
+            wrapped = (const ch_dynamic_att_com_protocol_packet_t *)at_time->packet;
+            return wrapped->header.command != DYNAMIC_ATT_PROTOCOL_CMD_AT_TIME &&
+                   packet->header.payload_size == sizeof(*at_time) + sizeof(wrapped->header) + wrapped->header.payload_size &&
+                   channel_dynamic_att_com_header_is_valid(&wrapped->header) &&
+                   channel_dynamic_att_com_payload_is_valid(wrapped);
+        default:
+            return true;
     }
-    bs_trace_error("Failed to read DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL data. Got %u bytes, but expected %u bytes\n", packet->header.payload_size, sizeof(ch_dynamic_att_com_protocol_set_att_all_t));
-    return false;
 }
 
-bool channel_dynamic_att_com_read_packet(ch_dynamic_att_com_protocol_packet_t *packet)
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_com_next_packet(void)
 {
-    bool return_val = false;
-
-    if (packet != NULL) {
-        if (channel_dynamic_att_com_read(sizeof(packet->header), &packet->header)) {
-            switch (packet->header.command) {
-                case DYNAMIC_ATT_PROTOCOL_CMD_RESET:
-                    return_val = true;
-                    break;
-                case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ALL:
-                    return_val = channel_dynamic_att_com_read_cmd_data_set_att_all(packet);
-                    break;
-                case DYNAMIC_ATT_PROTOCOL_CMD_SET_ATT_ONE:
-                    return_val = channel_dynamic_att_com_read_cmd_data_set_att_one(packet);
-                    break;
-                default:
-                    bs_trace_warning_line("Received unknown attenuation command: %u\n", packet->header.command);
+    const ch_dynamic_att_com_protocol_packet_t *packet;
+    ch_dynamic_att_com_protocol_header_t header;
+    size_t pending;
+    size_t packet_size;
+
+    if (!ch_dynamic_att_com_prv.buffer) {
+        return NULL;
+    }
+
+    while ((pending = ch_dynamic_att_com_prv.buffer_tail - ch_dynamic_att_com_prv.buffer_head) >= sizeof(header)) {
+        memcpy(&header, ch_dynamic_att_com_prv.buffer + ch_dynamic_att_com_prv.buffer_head, sizeof(header));
+
+        packet = (const ch_dynamic_att_com_protocol_packet_t *)(ch_dynamic_att_com_prv.buffer + ch_dynamic_att_com_prv.buffer_head);
+        packet_size = sizeof(header) + header.payload_size;
+
+        if (channel_dynamic_att_com_header_is_valid(&header)) {
+            if (pending < packet_size) {
+                /* Rest of the payload has not arrived yet, keep it for the next poll */
+                ch_dynamic_att_stats->partial_reads++;
+                break;
             }
+            if (channel_dynamic_att_com_payload_is_valid(packet)) {
+                ch_dynamic_att_com_prv.in_sync = true;
+                ch_dynamic_att_com_prv.buffer_head += packet_size;
+                return packet;
+            }
+        }
+
+        /* Out of frame: slide one byte at a time until a valid packet shows up again */
+        if (ch_dynamic_att_com_prv.in_sync) {
+            bs_trace_warning_line("Received malformed attenuation command (cmd=%u, size=%u), resynchronizing\n",
+                                  header.command, header.payload_size);
+            ch_dynamic_att_com_prv.in_sync = false;
+            ch_dynamic_att_stats->malformed++;
         }
+        ch_dynamic_att_stats->skipped_bytes++;
+        ch_dynamic_att_com_prv.buffer_head++;
     }
-    return return_val;
+
+    return NULL;
 }
@@ -16,8 +16,9 @@ extern "C" {
  *
  * @param sim_id The current SIM ID used for logical path for fifo
  * @param fifo_name The logical name of the fifo
+ * @param use_shm Receive commands through a shared memory ring named after the fifo, instead of the fifo
  */
-void channel_dynamic_att_com_open(char *sim_id, char *fifo_name);
+void channel_dynamic_att_com_open(char *sim_id, char *fifo_name, bool use_shm);
 
 /**
  * @brief Close client communication
@@ -25,12 +26,24 @@ void channel_dynamic_att_com_open(char *sim_id, char *fifo_name);
 void channel_dynamic_att_com_close(void);
 
 /**
- * @brief Read an entire packet from fifo
+ * @brief Read everything currently available on the fifo or shared memory ring into the receive buffer
  *
- * @param packet Pointer to allocated memory for full packet structure
- * @return True if a packet was read and validated
+ * Does at most one non-blocking read. Incomplete packets are kept until the rest arrives.
+ * With the shared memory ring, checking for new data is a single atomic load.
+ *
+ * @return Number of bytes read
+ */
+size_t channel_dynamic_att_com_poll(void);
+
+/**
+ * @brief Get the next complete and validated packet from the receive buffer
+ *
+ * Malformed data is skipped until the stream is back in frame.
+ *
+ * @return Pointer to the packet, valid until the next call to @ref channel_dynamic_att_com_poll,
+ *         or NULL if no complete packet is buffered
 */
-bool channel_dynamic_att_com_read_packet(ch_dynamic_att_com_protocol_packet_t *packet);
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_com_next_packet(void);
 
 #ifdef __cplusplus
 }
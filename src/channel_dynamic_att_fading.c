@@ -0,0 +1,381 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_fading.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DYNAMIC_ATT_FADING_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * The fading of a link is a function of (seed, tx, rx, now / coherence time) only, so it does not
+ * depend on the order links are evaluated in and is the same in every run with the same seed.
+ *
+ * For every channel_calc() the random numbers of all transmitters to one receiver are produced
+ * in one batch: a key is derived once from (seed, rx, time), then each active transmitter's number
+ * is a 32 bit integer hash of key + tx, which the AVX2 kernel computes for 8 transmitters at a time,
+ * skipping blocks without active transmitters like the attenuation gather kernels do. The kernel
+ * lists the blocks with active transmitters, so the rest of the work skips the other blocks too.
+ * The top bits of the number select an entry of a table holding the quantiles of the
+ * distribution at unit standard deviation, so turning a number into fading is one lookup and no
+ * transcendental functions are evaluated during the simulation. The table has 4096 entries,
+ * which bounds Gaussian fading to about 3.7 standard deviations.
+ *
+ * The standard deviation of a link is the one set last: either for one of its two devices, or
+ * for the link itself. Devices and links therefore carry the sequence number of the command
+ * which set them, and the link setting is kept in a hash table only for links set individually.
+ */
+
+#define DYNAMIC_ATT_FADING_TABLE_BITS (12U)
+#define DYNAMIC_ATT_FADING_TABLE_SIZE (1U << DYNAMIC_ATT_FADING_TABLE_BITS)
+#define DYNAMIC_ATT_FADING_MIN_CAPACITY (64U)
+/* Standard deviation in dB of the power of a Rayleigh faded signal, (10/ln(10))*pi/sqrt(6) */
+#define DYNAMIC_ATT_FADING_RAYLEIGH_SIGMA (5.5697)
+
+/* Transmitters are handled in blocks of this many, the block size of the AVX2 kernel */
+#define DYNAMIC_ATT_FADING_BLOCK (8U)
+
+/*
+ * Sets hashes[tx] of every active transmitter, and lists the first transmitter of every block with
+ * an active transmitter in blocks[]. Returns the number of such blocks.
+ */
+typedef uint (*ch_dynamic_att_fading_kernel_t)(uint32_t key, const uint *tx_used, uint count, uint *blocks, uint32_t *hashes);
+
+static struct {
+    ch_dynamic_att_fading_t        fading;
+    uint                           num_devices;
+    double                         default_sigma;
+    uint                           seed;
+    uint                           coherence_time;
+    double                         table[DYNAMIC_ATT_FADING_TABLE_SIZE];
+    uint                          *blocks;
+    uint32_t                      *hashes;
+    ch_dynamic_att_fading_kernel_t kernel;
+
+    uint                           seq;          /* Of the last setting, 0 when nothing was set since the last reset */
+    double                        *device_sigma;
+    uint                          *device_seq;
+    uint64_t                      *link_keys;    /* rx*num_devices + tx + 1, 0 marks an empty slot */
+    double                        *link_sigma;
+    uint                          *link_seq;
+    uint                           link_capacity;
+    uint                           link_count;
+} ch_dynamic_att_fading_prv = {0};
+
+/*
+ * Random numbers
+ */
+
+static inline uint32_t channel_dynamic_att_fading_mix(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352DU;
+    x ^= x >> 15;
+    x *= 0x846CA68BU;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline uint32_t channel_dynamic_att_fading_hash(uint32_t key, uint tx)
+{
+    return channel_dynamic_att_fading_mix(channel_dynamic_att_fading_mix(key + tx*0x9E3779B9U));
+}
+
+static uint channel_dynamic_att_fading_kernel_scalar(uint32_t key, const uint *tx_used, uint count, uint *blocks, uint32_t *hashes)
+{
+    uint n = 0U;
+
+    for (uint tx = 0U; tx < count; tx++) {
+        if (tx_used[tx]) {
+            uint first = tx & ~(DYNAMIC_ATT_FADING_BLOCK - 1U);
+
+            hashes[tx] = channel_dynamic_att_fading_hash(key, tx);
+            if (n == 0U || blocks[n - 1U] != first) {
+                blocks[n++] = first;
+            }
+        }
+    }
+    return n;
+}
+
+#ifdef DYNAMIC_ATT_FADING_X86
+__attribute__((target("avx2")))
+static inline __m256i channel_dynamic_att_fading_mix_avx2(__m256i x)
+{
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7FEB352D));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x846CA68BU));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    return x;
+}
+
+__attribute__((target("avx2")))
+static uint channel_dynamic_att_fading_kernel_avx2(uint32_t key, const uint *tx_used, uint count, uint *blocks, uint32_t *hashes)
+{
+    const __m256i step = _mm256_set1_epi32((int)(8U*0x9E3779B9U));
+    __m256i x = _mm256_add_epi32(_mm256_set1_epi32((int)key),
+                                 _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)0x9E3779B9U)));
+    uint n = 0U;
+    uint tx = 0U;
+
+    for (; tx + 8U <= count; tx += 8U) {
+        __m256i used = _mm256_loadu_si256((const __m256i *)(tx_used + tx));
+
+        /* All 8 hashes cost about as much as one, so hash the whole block if any transmitter is active */
+        if (!_mm256_testz_si256(used, used)) {
+            _mm256_storeu_si256((__m256i *)(hashes + tx), channel_dynamic_att_fading_mix_avx2(channel_dynamic_att_fading_mix_avx2(x)));
+            blocks[n++] = tx;
+        }
+        x = _mm256_add_epi32(x, step);
+    }
+    if (tx < count) {
+        bool any = false;
+
+        for (uint last = tx; last < count; last++) {
+            if (tx_used[last]) {
+                hashes[last] = channel_dynamic_att_fading_hash(key, last);
+                any = true;
+            }
+        }
+        if (any) {
+            blocks[n++] = tx;
+        }
+    }
+    return n;
+}
+#endif
+
+/*
+ * Quantile table of the distribution, at unit standard deviation
+ */
+static void channel_dynamic_att_fading_table_init(ch_dynamic_att_fading_t fading)
+{
+    for (uint i = 0U; i < DYNAMIC_ATT_FADING_TABLE_SIZE; i++) {
+        double p = (i + 0.5)/DYNAMIC_ATT_FADING_TABLE_SIZE;
+
+        if (fading == DYNAMIC_ATT_FADING_RAYLEIGH) {
+            /* Attenuation in dB of an exponentially distributed power with mean 1 */
+            ch_dynamic_att_fading_prv.table[i] = -10.0*log10(-log(p))/DYNAMIC_ATT_FADING_RAYLEIGH_SIGMA;
+        } else {
+            /* Invert the normal distribution function by bisection */
+            double low = -10.0;
+            double high = 10.0;
+
+            for (uint n = 0U; n < 64U; n++) {
+                double mid = 0.5*(low + high);
+
+                if (0.5*erfc(-mid/sqrt(2.0)) < p) {
+                    low = mid;
+                } else {
+                    high = mid;
+                }
+            }
+            ch_dynamic_att_fading_prv.table[i] = 0.5*(low + high);
+        }
+    }
+}
+
+/*
+ * Standard deviations
+ */
+
+static bool channel_dynamic_att_fading_find(uint64_t key, uint *slot)
+{
+    uint mask = ch_dynamic_att_fading_prv.link_capacity - 1U;
+    uint i = (uint)((key*0x9E3779B97F4A7C15ULL) >> 40) & mask;
+
+    while (ch_dynamic_att_fading_prv.link_keys[i]) {
+        if (ch_dynamic_att_fading_prv.link_keys[i] == key) {
+            *slot = i;
+            return true;
+        }
+        i = (i + 1U) & mask;
+    }
+    *slot = i;
+    return false;
+}
+
+static void channel_dynamic_att_fading_grow(void)
+{
+    uint64_t *old_keys = ch_dynamic_att_fading_prv.link_keys;
+    double *old_sigma = ch_dynamic_att_fading_prv.link_sigma;
+    uint *old_seq = ch_dynamic_att_fading_prv.link_seq;
+    uint old_capacity = ch_dynamic_att_fading_prv.link_capacity;
+    uint slot;
+
+    ch_dynamic_att_fading_prv.link_capacity = old_capacity ? old_capacity*2U : DYNAMIC_ATT_FADING_MIN_CAPACITY;
+    ch_dynamic_att_fading_prv.link_keys = bs_calloc(ch_dynamic_att_fading_prv.link_capacity, sizeof(uint64_t));
+    ch_dynamic_att_fading_prv.link_sigma = bs_calloc(ch_dynamic_att_fading_prv.link_capacity, sizeof(double));
+    ch_dynamic_att_fading_prv.link_seq = bs_calloc(ch_dynamic_att_fading_prv.link_capacity, sizeof(uint));
+    if (!ch_dynamic_att_fading_prv.link_keys || !ch_dynamic_att_fading_prv.link_sigma || !ch_dynamic_att_fading_prv.link_seq) {
+        bs_trace_error("Error allocating memory for link fading");
+    }
+
+    for (uint i = 0U; i < old_capacity; i++) {
+        if (old_keys[i]) {
+            channel_dynamic_att_fading_find(old_keys[i], &slot);
+            ch_dynamic_att_fading_prv.link_keys[slot] = old_keys[i];
+            ch_dynamic_att_fading_prv.link_sigma[slot] = old_sigma[i];
+            ch_dynamic_att_fading_prv.link_seq[slot] = old_seq[i];
+        }
+    }
+    free(old_keys);
+    free(old_sigma);
+    free(old_seq);
+}
+
+static double channel_dynamic_att_fading_sigma(uint tx, uint rx)
+{
+    uint device = (ch_dynamic_att_fading_prv.device_seq[tx] > ch_dynamic_att_fading_prv.device_seq[rx]) ? tx : rx;
+    uint slot;
+
+    if (ch_dynamic_att_fading_prv.link_count &&
+        channel_dynamic_att_fading_find((uint64_t)rx*ch_dynamic_att_fading_prv.num_devices + tx + 1U, &slot) &&
+        ch_dynamic_att_fading_prv.link_seq[slot] > ch_dynamic_att_fading_prv.device_seq[device]) {
+        return ch_dynamic_att_fading_prv.link_sigma[slot];
+    }
+    return ch_dynamic_att_fading_prv.device_sigma[device];
+}
+
+/*
+ * Public API
+ */
+
+void channel_dynamic_att_fading_init(uint num_devices, ch_dynamic_att_fading_t fading, double default_sigma, uint seed, uint coherence_time)
+{
+    const char *kernel_name;
+
+    ch_dynamic_att_fading_prv.fading = fading;
+    ch_dynamic_att_fading_prv.num_devices = num_devices;
+    ch_dynamic_att_fading_prv.default_sigma = default_sigma;
+    ch_dynamic_att_fading_prv.seed = seed;
+    ch_dynamic_att_fading_prv.coherence_time = coherence_time ? coherence_time : 1U;
+
+    ch_dynamic_att_fading_prv.blocks = bs_calloc(num_devices/DYNAMIC_ATT_FADING_BLOCK + 1U, sizeof(uint));
+    ch_dynamic_att_fading_prv.hashes = bs_calloc(num_devices, sizeof(uint32_t));
+    ch_dynamic_att_fading_prv.device_sigma = bs_calloc(num_devices, sizeof(double));
+    ch_dynamic_att_fading_prv.device_seq = bs_calloc(num_devices, sizeof(uint));
+    if (!ch_dynamic_att_fading_prv.blocks || !ch_dynamic_att_fading_prv.hashes || !ch_dynamic_att_fading_prv.device_sigma || !ch_dynamic_att_fading_prv.device_seq) {
+        bs_trace_error("Error allocating memory for fading");
+    }
+    channel_dynamic_att_fading_table_init(fading);
+    channel_dynamic_att_fading_reset();
+
+    ch_dynamic_att_fading_prv.kernel = channel_dynamic_att_fading_kernel_scalar;
+    kernel_name = "scalar";
+#ifdef DYNAMIC_ATT_FADING_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        ch_dynamic_att_fading_prv.kernel = channel_dynamic_att_fading_kernel_avx2;
+        kernel_name = "avx2";
+    }
+#endif
+
+    bs_trace_raw(8, "channel_dynamic_att using %s fading of %lf dB, seed %u, with %s kernel\n",
+                 fading == DYNAMIC_ATT_FADING_RAYLEIGH ? "rayleigh" : "gauss", default_sigma, seed, kernel_name);
+}
+
+void channel_dynamic_att_fading_delete(void)
+{
+    free(ch_dynamic_att_fading_prv.blocks);
+    free(ch_dynamic_att_fading_prv.hashes);
+    free(ch_dynamic_att_fading_prv.device_sigma);
+    free(ch_dynamic_att_fading_prv.device_seq);
+    free(ch_dynamic_att_fading_prv.link_keys);
+    free(ch_dynamic_att_fading_prv.link_sigma);
+    free(ch_dynamic_att_fading_prv.link_seq);
+    memset(&ch_dynamic_att_fading_prv, 0, sizeof(ch_dynamic_att_fading_prv));
+}
+
+bool channel_dynamic_att_fading_is_enabled(void)
+{
+    return ch_dynamic_att_fading_prv.fading != DYNAMIC_ATT_FADING_NONE;
+}
+
+void channel_dynamic_att_fading_reset(void)
+{
+    for (uint device = 0U; device < ch_dynamic_att_fading_prv.num_devices; device++) {
+        ch_dynamic_att_fading_prv.device_sigma[device] = ch_dynamic_att_fading_prv.default_sigma;
+        ch_dynamic_att_fading_prv.device_seq[device] = 0U;
+    }
+    if (ch_dynamic_att_fading_prv.link_count) {
+        memset(ch_dynamic_att_fading_prv.link_keys, 0, ch_dynamic_att_fading_prv.link_capacity*sizeof(uint64_t));
+        ch_dynamic_att_fading_prv.link_count = 0U;
+    }
+    ch_dynamic_att_fading_prv.seq = 0U;
+}
+
+void channel_dynamic_att_fading_set_device(uint device, double sigma)
+{
+    ch_dynamic_att_fading_prv.device_sigma[device] = sigma;
+    ch_dynamic_att_fading_prv.device_seq[device] = ++ch_dynamic_att_fading_prv.seq;
+}
+
+void channel_dynamic_att_fading_set(uint tx, uint rx, double sigma)
+{
+    uint64_t key = (uint64_t)rx*ch_dynamic_att_fading_prv.num_devices + tx + 1U;
+    uint slot;
+
+    /* Keep the load factor at or below 1/2 */
+    if ((ch_dynamic_att_fading_prv.link_count + 1U)*2U > ch_dynamic_att_fading_prv.link_capacity) {
+        channel_dynamic_att_fading_grow();
+    }
+    if (!channel_dynamic_att_fading_find(key, &slot)) {
+        ch_dynamic_att_fading_prv.link_keys[slot] = key;
+        ch_dynamic_att_fading_prv.link_count++;
+    }
+    ch_dynamic_att_fading_prv.link_sigma[slot] = sigma;
+    ch_dynamic_att_fading_prv.link_seq[slot] = ++ch_dynamic_att_fading_prv.seq;
+}
+
+void channel_dynamic_att_fading_apply(uint rx, const uint *tx_used, bs_time_t now, double *att)
+{
+    uint64_t period = now/ch_dynamic_att_fading_prv.coherence_time;
+    const double *table = ch_dynamic_att_fading_prv.table;
+    const uint *blocks = ch_dynamic_att_fading_prv.blocks;
+    const uint32_t *hashes = ch_dynamic_att_fading_prv.hashes;
+    uint num_devices = ch_dynamic_att_fading_prv.num_devices;
+    uint32_t key;
+    uint num_blocks;
+
+    key = channel_dynamic_att_fading_mix(ch_dynamic_att_fading_prv.seed ^
+                                         channel_dynamic_att_fading_mix(rx ^
+                                         channel_dynamic_att_fading_mix((uint32_t)period ^
+                                         channel_dynamic_att_fading_mix((uint32_t)(period >> 32)))));
+    num_blocks = ch_dynamic_att_fading_prv.kernel(key, tx_used, num_devices, ch_dynamic_att_fading_prv.blocks, ch_dynamic_att_fading_prv.hashes);
+
+    if (ch_dynamic_att_fading_prv.seq == 0U) {
+        /* Nothing set since the last reset, all links use the default */
+        double sigma = ch_dynamic_att_fading_prv.default_sigma;
+
+        for (uint b = 0U; b < num_blocks; b++) {
+            uint end = (blocks[b] + DYNAMIC_ATT_FADING_BLOCK < num_devices) ? blocks[b] + DYNAMIC_ATT_FADING_BLOCK : num_devices;
+
+            for (uint tx = blocks[b]; tx < end; tx++) {
+                if (tx_used[tx]) {
+                    att[tx] += sigma*table[hashes[tx] >> (32U - DYNAMIC_ATT_FADING_TABLE_BITS)];
+                }
+            }
+        }
+        return;
+    }
+    for (uint b = 0U; b < num_blocks; b++) {
+        uint end = (blocks[b] + DYNAMIC_ATT_FADING_BLOCK < num_devices) ? blocks[b] + DYNAMIC_ATT_FADING_BLOCK : num_devices;
+
+        for (uint tx = blocks[b]; tx < end; tx++) {
+            if (tx_used[tx]) {
+                att[tx] += channel_dynamic_att_fading_sigma(tx, rx)*table[hashes[tx] >> (32U - DYNAMIC_ATT_FADING_TABLE_BITS)];
+            }
+        }
+    }
+}
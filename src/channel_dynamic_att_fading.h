@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_FADING_H
+#define _CHANNEL_DYNAMIC_ATT_FADING_H
+
+#include "bs_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DYNAMIC_ATT_FADING_NONE = 0, /* No fading overlay */
+    DYNAMIC_ATT_FADING_GAUSS,    /* Normally distributed attenuation in dB (log-normal shadowing) */
+    DYNAMIC_ATT_FADING_RAYLEIGH, /* Attenuation in dB of a Rayleigh faded signal */
+} ch_dynamic_att_fading_t;
+
+/**
+ * @brief Enable the fading overlay
+ *
+ * @param num_devices Number of devices in the simulation
+ * @param fading Distribution of the fading
+ * @param default_sigma Standard deviation in dB of links whose fading has not been set
+ * @param seed Seed of the random numbers, the same seed gives the same fading
+ * @param coherence_time Simulation time in microseconds over which the fading of a link stays the same, at least 1
+ */
+void channel_dynamic_att_fading_init(uint num_devices, ch_dynamic_att_fading_t fading, double default_sigma, uint seed, uint coherence_time);
+
+/**
+ * @brief Free the fading overlay, if any
+ */
+void channel_dynamic_att_fading_delete(void);
+
+/**
+ * @brief True if the fading overlay is enabled
+ */
+bool channel_dynamic_att_fading_is_enabled(void);
+
+/**
+ * @brief Set all links back to the default standard deviation
+ */
+void channel_dynamic_att_fading_reset(void);
+
+/**
+ * @brief Set the standard deviation of all links to and from a device
+ */
+void channel_dynamic_att_fading_set_device(uint device, double sigma);
+
+/**
+ * @brief Set the standard deviation of the link from tx to rx
+ */
+void channel_dynamic_att_fading_set(uint tx, uint rx, double sigma);
+
+/**
+ * @brief Add the fading of every active transmitter to rx at <now>
+ *
+ * @param rx      The receiving device
+ * @param tx_used Array with num_devices elements, non-zero for active transmitters
+ * @param now     Current simulation time
+ * @param att     Array with num_devices elements. Only the elements of active transmitters are changed.
+ */
+void channel_dynamic_att_fading_apply(uint rx, const uint *tx_used, bs_time_t now, double *att);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_FADING_H */
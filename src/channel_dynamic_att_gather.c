@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "channel_dynamic_att_gather.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DYNAMIC_ATT_GATHER_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*ch_dynamic_att_gather_kernel_t)(const double *row, const unsigned int *tx_used, size_t count, double *att);
+
+static struct {
+    ch_dynamic_att_gather_kernel_t kernel;
+    const char                    *name;
+} ch_dynamic_att_gather_prv = {
+    .kernel = channel_dynamic_att_gather_scalar,
+    .name   = "scalar"
+};
+
+void channel_dynamic_att_gather_scalar(const double *row, const unsigned int *tx_used, size_t count, double *att)
+{
+    for (size_t i = 0U; i < count; i++) {
+        if (tx_used[i]) {
+            att[i] = row[i];
+        }
+    }
+}
+
+#ifdef DYNAMIC_ATT_GATHER_X86
+#if defined(__SSE2__)
+/*
+ * SSE2 has no masked store, so blend the row into the current att values instead.
+ * Unused entries are written back unchanged.
+ */
+static void channel_dynamic_att_gather_sse2(const double *row, const unsigned int *tx_used, size_t count, double *att)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0U;
+
+    for (; i + 4U <= count; i += 4U) {
+        __m128i used = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(tx_used + i)), zero);
+
+        if (_mm_movemask_epi8(used) == 0xFFFF) {
+            /* No transmitters in this block */
+            continue;
+        }
+        if (_mm_movemask_epi8(used) == 0) {
+            /* All transmitters in this block */
+            _mm_storeu_pd(att + i,      _mm_loadu_pd(row + i));
+            _mm_storeu_pd(att + i + 2U, _mm_loadu_pd(row + i + 2U));
+            continue;
+        }
+        /* Widen the 32 bit "unused" masks to 64 bit lanes */
+        __m128d skip_lo = _mm_castsi128_pd(_mm_unpacklo_epi32(used, used));
+        __m128d skip_hi = _mm_castsi128_pd(_mm_unpackhi_epi32(used, used));
+
+        _mm_storeu_pd(att + i,      _mm_or_pd(_mm_and_pd(skip_lo, _mm_loadu_pd(att + i)),
+                                              _mm_andnot_pd(skip_lo, _mm_loadu_pd(row + i))));
+        _mm_storeu_pd(att + i + 2U, _mm_or_pd(_mm_and_pd(skip_hi, _mm_loadu_pd(att + i + 2U)),
+                                              _mm_andnot_pd(skip_hi, _mm_loadu_pd(row + i + 2U))));
+    }
+    channel_dynamic_att_gather_scalar(row + i, tx_used + i, count - i, att + i);
+}
+#endif
+
+__attribute__((target("avx2")))
+static void channel_dynamic_att_gather_avx2(const double *row, const unsigned int *tx_used, size_t count, double *att)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0U;
+
+    for (; i + 8U <= count; i += 8U) {
+        __m256i unused = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(tx_used + i)), zero);
+
+        if (_mm256_movemask_epi8(unused) == -1) {
+            /* No transmitters in this block */
+            continue;
+        }
+        if (_mm256_movemask_epi8(unused) == 0) {
+            /* All transmitters in this block, a plain copy is cheaper than masked stores */
+            _mm256_storeu_pd(att + i,      _mm256_loadu_pd(row + i));
+            _mm256_storeu_pd(att + i + 4U, _mm256_loadu_pd(row + i + 4U));
+            continue;
+        }
+        __m256i used = _mm256_xor_si256(unused, _mm256_cmpeq_epi32(zero, zero));
+
+        _mm256_maskstore_pd(att + i,      _mm256_cvtepi32_epi64(_mm256_castsi256_si128(used)),      _mm256_loadu_pd(row + i));
+        _mm256_maskstore_pd(att + i + 4U, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(used, 1)), _mm256_loadu_pd(row + i + 4U));
+    }
+    channel_dynamic_att_gather_scalar(row + i, tx_used + i, count - i, att + i);
+}
+#endif
+
+void channel_dynamic_att_gather_init(void)
+{
+#ifdef DYNAMIC_ATT_GATHER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        ch_dynamic_att_gather_prv.kernel = channel_dynamic_att_gather_avx2;
+        ch_dynamic_att_gather_prv.name   = "avx2";
+        return;
+    }
+#if defined(__SSE2__)
+    ch_dynamic_att_gather_prv.kernel = channel_dynamic_att_gather_sse2;
+    ch_dynamic_att_gather_prv.name   = "sse2";
+    return;
+#endif
+#endif
+    ch_dynamic_att_gather_prv.kernel = channel_dynamic_att_gather_scalar;
+    ch_dynamic_att_gather_prv.name   = "scalar";
+}
+
+const char *channel_dynamic_att_gather_kernel_name(void)
+{
+    return ch_dynamic_att_gather_prv.name;
+}
+
+void channel_dynamic_att_gather(const double *row, const unsigned int *tx_used, size_t count, double *att)
+{
+    ch_dynamic_att_gather_prv.kernel(row, tx_used, count, att);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_GATHER_H
+#define _CHANNEL_DYNAMIC_ATT_GATHER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Select the fastest masked copy kernel supported by the host CPU
+ *
+ * Must be called before @ref channel_dynamic_att_gather
+ */
+void channel_dynamic_att_gather_init(void);
+
+/**
+ * @brief Name of the selected kernel, for tracing and benchmarks
+ */
+const char *channel_dynamic_att_gather_kernel_name(void);
+
+/**
+ * @brief Masked copy of one attenuation matrix row
+ *
+ * For each i in [0, count): att[i] = row[i] if tx_used[i] is non-zero.
+ * Elements of att where tx_used[i] is zero keep their value.
+ *
+ * @param row     Contiguous attenuation values for all transmitters to one receiver
+ * @param tx_used Array with count elements, non-zero for active transmitters
+ * @param count   Number of devices
+ * @param att     Destination array with count elements
+ */
+void channel_dynamic_att_gather(const double *row, const unsigned int *tx_used, size_t count, double *att);
+
+/**
+ * @brief Plain C reference implementation of @ref channel_dynamic_att_gather
+ */
+void channel_dynamic_att_gather_scalar(const double *row, const unsigned int *tx_used, size_t count, double *att);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_GATHER_H */
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+** Include this file before including system headers.  By default, with
+** C99 support from the compiler, it requests POSIX 2008 support.  With
+** C89 support only, it requests POSIX 1997 support.  Override the
+** default behaviour by setting either _XOPEN_SOURCE or _POSIX_C_SOURCE.
+*/
+/* _XOPEN_SOURCE 700 is loosely equivalent to _POSIX_C_SOURCE 200809L */
+/* _XOPEN_SOURCE 600 is loosely equivalent to _POSIX_C_SOURCE 200112L */
+/* _XOPEN_SOURCE 500 is loosely equivalent to _POSIX_C_SOURCE 199506L */
+#if !defined(_XOPEN_SOURCE) && !defined(_POSIX_C_SOURCE)
+#if defined(__cplusplus)
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#elif __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#else
+#define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
+#endif /* __STDC_VERSION__ */
+#endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <stdio.h>
+#include <string.h>
+#include <dlfcn.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_inner.h"
+
+/*
+ * Layered mode: another channel library (e.g. multipath or indoor) is loaded next to this one, and
+ * each channel_calc() adds its attenuation to the attenuation of this channel.
+ *
+ * The inner library exports the same channel_init/channel_calc/channel_delete symbols as this one,
+ * so it is loaded with RTLD_LOCAL and its functions are only found through its own handle.
+ *
+ * The inner channel writes into a row allocated once here, which is then added to the caller's
+ * row in a single pass over the active transmitters.
+ */
+
+typedef int  (*ch_dynamic_att_inner_init_t)(int argc, char *argv[], uint num_devices);
+typedef int  (*ch_dynamic_att_inner_calc_t)(const uint *tx_used, tx_el_t *tx_list, uint txnbr, uint rxnbr, bs_time_t now, double *att,
+                                            double *ISI_SNR);
+typedef void (*ch_dynamic_att_inner_delete_t)(void);
+
+static struct {
+    void                         *handle;
+    ch_dynamic_att_inner_init_t   init;
+    ch_dynamic_att_inner_calc_t   calc;
+    ch_dynamic_att_inner_delete_t delete;
+    uint                          num_devices;
+    double                       *att;
+} ch_dynamic_att_inner_prv = {0};
+
+static void *channel_dynamic_att_inner_symbol(const char *lib_name, const char *symbol)
+{
+    void *address = dlsym(ch_dynamic_att_inner_prv.handle, symbol);
+
+    if (!address) {
+        bs_trace_error_line("Inner channel %s does not define %s: %s\n", lib_name, symbol, dlerror());
+    }
+    return address;
+}
+
+/*
+ * Public API
+ */
+
+void channel_dynamic_att_inner_open(const char *name, int argc, char *argv[], uint num_devices)
+{
+    char lib_name[1024];
+    int length;
+
+    if (strchr(name, '/')) {
+        length = snprintf(lib_name, sizeof(lib_name), "%s", name);
+    } else {
+        length = snprintf(lib_name, sizeof(lib_name), "../lib/lib_2G4Channel_%s.so", name);
+    }
+    if (length < 0 || (size_t)length >= sizeof(lib_name)) {
+        bs_trace_error_line("Library path of inner channel %s is longer than %zu characters\n", name, sizeof(lib_name) - 1U);
+    }
+
+    ch_dynamic_att_inner_prv.handle = dlopen(lib_name, RTLD_NOW | RTLD_LOCAL);
+    if (!ch_dynamic_att_inner_prv.handle) {
+        bs_trace_error_line("Failed loading inner channel %s: %s\n", lib_name, dlerror());
+    }
+    /* ISO C has no object to function pointer conversion, so assign through a void * as POSIX suggests for dlsym() */
+    *(void **)&ch_dynamic_att_inner_prv.init = channel_dynamic_att_inner_symbol(lib_name, "channel_init");
+    *(void **)&ch_dynamic_att_inner_prv.calc = channel_dynamic_att_inner_symbol(lib_name, "channel_calc");
+    *(void **)&ch_dynamic_att_inner_prv.delete = channel_dynamic_att_inner_symbol(lib_name, "channel_delete");
+
+    ch_dynamic_att_inner_prv.num_devices = num_devices;
+    ch_dynamic_att_inner_prv.att = bs_calloc(num_devices, sizeof(double));
+    if (!ch_dynamic_att_inner_prv.att) {
+        bs_trace_error("Error allocating memory for the inner channel attenuation");
+    }
+
+    if (ch_dynamic_att_inner_prv.init(argc, argv, num_devices) < 0) {
+        bs_trace_error_line("Inner channel %s failed to initialize\n", lib_name);
+    }
+
+    bs_trace_raw(8, "channel_dynamic_att layered on top of %s\n", lib_name);
+}
+
+void channel_dynamic_att_inner_close(void)
+{
+    if (!ch_dynamic_att_inner_prv.handle) {
+        return;
+    }
+    ch_dynamic_att_inner_prv.delete();
+    dlclose(ch_dynamic_att_inner_prv.handle);
+    free(ch_dynamic_att_inner_prv.att);
+    memset(&ch_dynamic_att_inner_prv, 0, sizeof(ch_dynamic_att_inner_prv));
+}
+
+bool channel_dynamic_att_inner_is_open(void)
+{
+    return ch_dynamic_att_inner_prv.handle != NULL;
+}
+
+int channel_dynamic_att_inner_add(const uint *tx_used, tx_el_t *tx_list, uint txnbr, uint rxnbr, bs_time_t now, double *att,
+                                  double *ISI_SNR)
+{
+    double *inner_att = ch_dynamic_att_inner_prv.att;
+    int ret;
+
+    ret = ch_dynamic_att_inner_prv.calc(tx_used, tx_list, txnbr, rxnbr, now, inner_att, ISI_SNR);
+    for (uint tx = 0U; tx < ch_dynamic_att_inner_prv.num_devices; tx++) {
+        if (tx_used[tx]) {
+            att[tx] += inner_att[tx];
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_INNER_H
+#define _CHANNEL_DYNAMIC_ATT_INNER_H
+
+#include "bs_types.h"
+#include "channel_if.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Load another channel library and initialize it, to layer this channel on top of it
+ *
+ * @param name Channel name, loaded as ../lib/lib_2G4Channel_<name>.so like the phy does, or a path
+ *             to the library if it contains a '/'
+ * @param argc, argv Arguments for the inner channel
+ * @param num_devices Number of devices in the simulation
+ */
+void channel_dynamic_att_inner_open(const char *name, int argc, char *argv[], uint num_devices);
+
+/**
+ * @brief Delete the inner channel and unload its library, if any
+ */
+void channel_dynamic_att_inner_close(void);
+
+/**
+ * @brief True if an inner channel is loaded
+ */
+bool channel_dynamic_att_inner_is_open(void);
+
+/**
+ * @brief Evaluate the inner channel and add its attenuation to att
+ *
+ * The parameters are those of channel_calc(). att must already hold the attenuation of this
+ * channel for the active transmitters; the inner channel's attenuation is added to it, and its
+ * ISI estimate returned in ISI_SNR.
+ *
+ * @return The return value of the inner channel_calc()
+ */
+int channel_dynamic_att_inner_add(const uint *tx_used, tx_el_t *tx_list, uint txnbr, uint rxnbr, bs_time_t now, double *att,
+                                  double *ISI_SNR);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_INNER_H */
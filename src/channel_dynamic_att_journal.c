@@ -0,0 +1,158 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+** Include this file before including system headers.  By default, with
+** C99 support from the compiler, it requests POSIX 2008 support.  With
+** C89 support only, it requests POSIX 1997 support.  Override the
+** default behaviour by setting either _XOPEN_SOURCE or _POSIX_C_SOURCE.
+*/
+/* _XOPEN_SOURCE 700 is loosely equivalent to _POSIX_C_SOURCE 200809L */
+/* _XOPEN_SOURCE 600 is loosely equivalent to _POSIX_C_SOURCE 200112L */
+/* _XOPEN_SOURCE 500 is loosely equivalent to _POSIX_C_SOURCE 199506L */
+#if !defined(_XOPEN_SOURCE) && !defined(_POSIX_C_SOURCE)
+#if defined(__cplusplus)
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#elif __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#else
+#define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
+#endif /* __STDC_VERSION__ */
+#endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "channel_dynamic_att_journal.h"
+#include "channel_dynamic_att_journal_format.h"
+
+/*
+ * Recording goes through a stdio stream, so each applied command costs a copy into its buffer.
+ * Replay maps the file read only and walks the records in place.
+ */
+
+static struct {
+    FILE          *record_file;
+    unsigned char *replay_map;
+    size_t         replay_map_size;
+    size_t         replay_pos;
+} ch_dynamic_att_journal_prv = {0};
+
+void channel_dynamic_att_journal_record_open(const char *file_name, uint num_devices)
+{
+    ch_dynamic_att_journal_header_t header = {
+        .magic       = DYNAMIC_ATT_JOURNAL_MAGIC,
+        .version     = DYNAMIC_ATT_JOURNAL_VERSION,
+        .num_devices = num_devices,
+    };
+
+    ch_dynamic_att_journal_prv.record_file = fopen(file_name, "wb");
+    if (!ch_dynamic_att_journal_prv.record_file) {
+        bs_trace_error_line("Failed creating command journal %s\n", file_name);
+    }
+    if (fwrite(&header, sizeof(header), 1, ch_dynamic_att_journal_prv.record_file) != 1) {
+        bs_trace_error_line("Failed writing command journal %s\n", file_name);
+    }
+}
+
+void channel_dynamic_att_journal_record(bs_time_t now, const ch_dynamic_att_com_protocol_packet_t *packet)
+{
+    uint64_t record_time = now;
+
+    if (!ch_dynamic_att_journal_prv.record_file) {
+        return;
+    }
+
+    if (fwrite(&record_time, sizeof(record_time), 1, ch_dynamic_att_journal_prv.record_file) != 1 ||
+        fwrite(packet, sizeof(packet->header) + packet->header.payload_size, 1, ch_dynamic_att_journal_prv.record_file) != 1) {
+        bs_trace_warning_line("Failed writing command journal, recording stopped\n");
+        fclose(ch_dynamic_att_journal_prv.record_file);
+        ch_dynamic_att_journal_prv.record_file = NULL;
+    }
+}
+
+void channel_dynamic_att_journal_replay_open(const char *file_name, uint num_devices)
+{
+    const ch_dynamic_att_journal_header_t *header;
+    struct stat file_stat;
+    int fd;
+
+    fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        bs_trace_error_line("Failed opening command journal %s\n", file_name);
+    }
+    if (fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(ch_dynamic_att_journal_header_t)) {
+        bs_trace_error_line("Command journal %s is too small\n", file_name);
+    }
+
+    ch_dynamic_att_journal_prv.replay_map_size = file_stat.st_size;
+    ch_dynamic_att_journal_prv.replay_map = mmap(NULL, ch_dynamic_att_journal_prv.replay_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ch_dynamic_att_journal_prv.replay_map == MAP_FAILED) {
+        ch_dynamic_att_journal_prv.replay_map = NULL;
+        bs_trace_error_line("Failed mapping command journal %s\n", file_name);
+    }
+
+    header = (const ch_dynamic_att_journal_header_t *)ch_dynamic_att_journal_prv.replay_map;
+    if (header->magic != DYNAMIC_ATT_JOURNAL_MAGIC || header->version != DYNAMIC_ATT_JOURNAL_VERSION) {
+        bs_trace_error_line("%s is not a version %u command journal\n", file_name, DYNAMIC_ATT_JOURNAL_VERSION);
+    }
+    if (header->num_devices != num_devices) {
+        bs_trace_error_line("Command journal %s is for %u devices, but the simulation has %u\n",
+                            file_name, header->num_devices, num_devices);
+    }
+    ch_dynamic_att_journal_prv.replay_pos = sizeof(*header);
+
+    /* Records are read in order, let the OS read ahead */
+    posix_madvise(ch_dynamic_att_journal_prv.replay_map, ch_dynamic_att_journal_prv.replay_map_size, POSIX_MADV_SEQUENTIAL);
+    bs_trace_raw(8, "channel_dynamic_att replaying command journal %s\n", file_name);
+}
+
+bool channel_dynamic_att_journal_is_replaying(void)
+{
+    return ch_dynamic_att_journal_prv.replay_map != NULL;
+}
+
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_journal_replay_next(bs_time_t now)
+{
+    const ch_dynamic_att_com_protocol_at_time_t *record;
+    const ch_dynamic_att_com_protocol_packet_t *packet;
+    size_t remaining = ch_dynamic_att_journal_prv.replay_map_size - ch_dynamic_att_journal_prv.replay_pos;
+    size_t record_size;
+
+    if (remaining < sizeof(*record) + sizeof(packet->header)) {
+        return NULL;
+    }
+
+    record = (const ch_dynamic_att_com_protocol_at_time_t *)(ch_dynamic_att_journal_prv.replay_map + ch_dynamic_att_journal_prv.replay_pos);
+    packet = (const ch_dynamic_att_com_protocol_packet_t *)record->packet;
+    if ((bs_time_t)record->apply_time > now) {
+        return NULL;
+    }
+
+    record_size = sizeof(*record) + sizeof(packet->header) + packet->header.payload_size;
+    if (record_size > remaining) {
+        bs_trace_error_line("Command journal is truncated\n");
+    }
+    ch_dynamic_att_journal_prv.replay_pos += record_size;
+
+    return packet;
+}
+
+void channel_dynamic_att_journal_close(void)
+{
+    if (ch_dynamic_att_journal_prv.record_file) {
+        fclose(ch_dynamic_att_journal_prv.record_file);
+        ch_dynamic_att_journal_prv.record_file = NULL;
+    }
+    if (ch_dynamic_att_journal_prv.replay_map) {
+        munmap(ch_dynamic_att_journal_prv.replay_map, ch_dynamic_att_journal_prv.replay_map_size);
+        ch_dynamic_att_journal_prv.replay_map = NULL;
+    }
+}
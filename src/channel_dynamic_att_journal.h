@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_JOURNAL_H
+#define _CHANNEL_DYNAMIC_ATT_JOURNAL_H
+
+#include "bs_types.h"
+#include "channel_dynamic_att_com_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start recording applied commands to a journal file
+ *
+ * @param file_name Path of the journal file, replaced if it exists
+ * @param num_devices Number of devices in the simulation
+ */
+void channel_dynamic_att_journal_record_open(const char *file_name, uint num_devices);
+
+/**
+ * @brief Append an applied command to the journal, if recording
+ *
+ * @param now Simulation time of the channel evaluation applying the command
+ * @param packet The command
+ */
+void channel_dynamic_att_journal_record(bs_time_t now, const ch_dynamic_att_com_protocol_packet_t *packet);
+
+/**
+ * @brief Map a journal file for replay
+ *
+ * @param file_name Path of the journal file
+ * @param num_devices Number of devices in the simulation, must match the file
+ */
+void channel_dynamic_att_journal_replay_open(const char *file_name, uint num_devices);
+
+/**
+ * @brief True if a journal is being replayed
+ */
+bool channel_dynamic_att_journal_is_replaying(void);
+
+/**
+ * @brief Take the next journal command which is due at <now>
+ *
+ * @param now Current simulation time
+ * @return Pointer to the command, valid until the journal is closed, or NULL if no command is due
+ */
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_journal_replay_next(bs_time_t now);
+
+/**
+ * @brief Finish recording and replaying
+ */
+void channel_dynamic_att_journal_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_JOURNAL_H */
@@ -0,0 +1,625 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_defaults.h"
+#include "channel_dynamic_att_gather.h"
+#include "channel_dynamic_att_matrix.h"
+
+/*
+ * The attenuation matrix is organized as rows for the Rx device and columns for the Tx device.
+ * To find the attenuation between two devices select the Rx device row and then the Tx column.
+ * Note that attenuation can be different for each direction.
+ * This keeps the attenuation from all transmitters to one receiver contiguous, which is the
+ * order channel_calc() reads it in.
+ *
+ * This is an example of the attenuation matrix when attenuation is set to 100 dBm between
+ * device 2 and all the others:
+ *
+ *    \ Tx 0   1   2   3
+ *   Rx +----------------
+ *    0 |  -   d  100  d
+ *    1 |  d   -  100  d
+ *    2 | 100 100  -  100
+ *    3 |  d   d  100  -
+ *
+ * This is an example of the attenuation matrix when Rx attenuation to (this) device 0 from
+ * device 3 is set to 99 dBm and Tx attenuation is set to 77 dBm:
+ *
+ *    \ Tx 0   1   2   3
+ *   Rx +----------------
+ *    0 |  -   d   d   99
+ *    1 |  d   -   d   d
+ *    2 |  d   d   -   d
+ *    3 |  77  d   d   -
+ *
+ *  Legend: 'd' is the default attenuation.
+ *
+ * With sparse storage each Rx row is instead an open addressed hash table (linear probing)
+ * holding only the Tx columns which differ from the default attenuation. A lookup that misses
+ * returns the default attenuation, and a row without any entries allocates no memory.
+ *
+ * Resetting is constant time: every Rx row carries the epoch it was last written in, and a reset
+ * only advances the global epoch. A row from an older epoch reads as all default attenuation and
+ * is cleared the first time it is written or gathered again. This also means rows are not
+ * touched at all until they are first used.
+ *
+ * With groups, every device belongs to one of G groups and links are looked up in a small GxG
+ * group matrix, organized like the attenuation matrix with rows for the Rx group. The sparse rows
+ * then hold per link overrides, which take precedence over the group matrix, so a lookup that
+ * misses returns the group matrix entry of the two devices instead of the default attenuation.
+ * Moving a device to another group is a single write, and the group matrix stays in the L1 cache.
+ *
+ * With B frequency bins (dense storage only) every link holds B attenuations, one per bin, next
+ * to each other: the entry for tx to rx in bin b is at (rx*N + tx)*B + b. A receiver row is then
+ * N*B values, and the values a transmitter can be looked up with stay in one cache line for up
+ * to 8 bins. With one bin the layout is the plain NxN matrix.
+ */
+
+#define DYNAMIC_ATT_SPARSE_MIN_CAPACITY (8U)
+
+typedef struct {
+    uint   *keys;     /* Tx device number + 1, 0 marks an empty slot */
+    double *values;
+    uint    capacity; /* Power of two, 0 until the first entry is inserted */
+    uint    count;
+} ch_dynamic_att_sparse_row_t;
+
+static struct {
+    ch_dynamic_att_storage_t     storage;
+    double                       default_attenuation;
+    uint                         num_devices;
+    double                      *attenuation_matrix;
+    ch_dynamic_att_sparse_row_t *sparse_rows;
+    uint                        *row_epoch;
+    uint                         epoch;
+    uint                         num_groups;
+    unsigned char               *device_group;
+    double                      *group_matrix;
+    uint                         num_bins;
+    size_t                       row_size;    /* Values per dense row, num_devices*num_bins */
+    size_t                      *row_offset;  /* Symmetric storage: entry of i and j >= i at row_offset[i] + j */
+} ch_dynamic_att_matrix_prv = {0};
+
+static bool channel_dynamic_att_matrix_row_is_current(uint rx)
+{
+    return ch_dynamic_att_matrix_prv.row_epoch[rx] == ch_dynamic_att_matrix_prv.epoch;
+}
+
+/*
+ * Get a dense row, clearing it to the default attenuation first if it predates the last reset
+ */
+static double *channel_dynamic_att_dense_row(uint rx)
+{
+    double *row = ch_dynamic_att_matrix_prv.attenuation_matrix + rx*ch_dynamic_att_matrix_prv.row_size;
+
+    if (!channel_dynamic_att_matrix_row_is_current(rx)) {
+        for (size_t i = 0U; i < ch_dynamic_att_matrix_prv.row_size; i++) {
+            row[i] = ch_dynamic_att_matrix_prv.default_attenuation;
+        }
+        ch_dynamic_att_matrix_prv.row_epoch[rx] = ch_dynamic_att_matrix_prv.epoch;
+    }
+    return row;
+}
+
+/*
+ * Get a packed row of symmetric storage, indexed by the column from rx on, clearing it to the
+ * default attenuation first if it predates the last reset
+ */
+static double *channel_dynamic_att_symmetric_row(uint rx)
+{
+    double *row = ch_dynamic_att_matrix_prv.attenuation_matrix + ch_dynamic_att_matrix_prv.row_offset[rx];
+
+    if (!channel_dynamic_att_matrix_row_is_current(rx)) {
+        for (uint tx = rx; tx < ch_dynamic_att_matrix_prv.num_devices; tx++) {
+            row[tx] = ch_dynamic_att_matrix_prv.default_attenuation;
+        }
+        ch_dynamic_att_matrix_prv.row_epoch[rx] = ch_dynamic_att_matrix_prv.epoch;
+    }
+    return row;
+}
+
+static double channel_dynamic_att_symmetric_get(uint tx, uint rx)
+{
+    uint lo = (tx < rx) ? tx : rx;
+    uint hi = (tx < rx) ? rx : tx;
+
+    if (!channel_dynamic_att_matrix_row_is_current(lo)) {
+        return ch_dynamic_att_matrix_prv.default_attenuation;
+    }
+    return ch_dynamic_att_matrix_prv.attenuation_matrix[ch_dynamic_att_matrix_prv.row_offset[lo] + hi];
+}
+
+static void channel_dynamic_att_symmetric_gather(uint rx, const uint *tx_used, double *att)
+{
+    const double *matrix = ch_dynamic_att_matrix_prv.attenuation_matrix;
+    const size_t *row_offset = ch_dynamic_att_matrix_prv.row_offset;
+    double default_attenuation = ch_dynamic_att_matrix_prv.default_attenuation;
+
+    /* Transmitters before rx: column rx of their rows */
+    for (uint tx = 0U; tx < rx; tx++) {
+        if (tx_used[tx]) {
+            att[tx] = channel_dynamic_att_matrix_row_is_current(tx) ? matrix[row_offset[tx] + rx] : default_attenuation;
+        }
+    }
+    /* Transmitters from rx on: the contiguous tail of the row of rx */
+    channel_dynamic_att_gather(channel_dynamic_att_symmetric_row(rx) + rx, tx_used + rx, ch_dynamic_att_matrix_prv.num_devices - rx,
+                               att + rx);
+}
+
+/*
+ * Attenuation of a link which is not stored: the group matrix entry with groups, else the default
+ */
+static double channel_dynamic_att_matrix_fallback(uint tx, uint rx)
+{
+    if (ch_dynamic_att_matrix_prv.num_groups) {
+        return ch_dynamic_att_matrix_prv.group_matrix[ch_dynamic_att_matrix_prv.device_group[rx]*ch_dynamic_att_matrix_prv.num_groups +
+                                                      ch_dynamic_att_matrix_prv.device_group[tx]];
+    }
+    return ch_dynamic_att_matrix_prv.default_attenuation;
+}
+
+/*
+ * Sparse storage
+ */
+
+static uint channel_dynamic_att_sparse_hash(uint tx, uint capacity)
+{
+    uint hash = tx*0x9E3779B1U;
+
+    return (hash ^ (hash >> 16)) & (capacity - 1U);
+}
+
+/*
+ * Find the slot holding tx, or the empty slot where it would be inserted
+ */
+static bool channel_dynamic_att_sparse_find(const ch_dynamic_att_sparse_row_t *row, uint tx, uint *slot)
+{
+    uint mask = row->capacity - 1U;
+    uint i = channel_dynamic_att_sparse_hash(tx, row->capacity);
+
+    while (row->keys[i]) {
+        if (row->keys[i] == tx + 1U) {
+            *slot = i;
+            return true;
+        }
+        i = (i + 1U) & mask;
+    }
+    *slot = i;
+    return false;
+}
+
+static void channel_dynamic_att_sparse_grow(ch_dynamic_att_sparse_row_t *row)
+{
+    ch_dynamic_att_sparse_row_t old = *row;
+    uint slot;
+
+    row->capacity = old.capacity ? old.capacity*2U : DYNAMIC_ATT_SPARSE_MIN_CAPACITY;
+    row->keys = bs_calloc(row->capacity, sizeof(uint));
+    row->values = bs_calloc(row->capacity, sizeof(double));
+    if (!row->keys || !row->values) {
+        bs_trace_error("Error allocating memory for sparse attenuation row");
+    }
+
+    for (uint i = 0U; i < old.capacity; i++) {
+        if (old.keys[i]) {
+            channel_dynamic_att_sparse_find(row, old.keys[i] - 1U, &slot);
+            row->keys[slot] = old.keys[i];
+            row->values[slot] = old.values[i];
+        }
+    }
+    free(old.keys);
+    free(old.values);
+}
+
+/*
+ * Remove the entry in slot, shifting later entries of the same probe sequence back so
+ * lookups never need tombstones.
+ */
+static void channel_dynamic_att_sparse_remove(ch_dynamic_att_sparse_row_t *row, uint slot)
+{
+    uint mask = row->capacity - 1U;
+    uint hole = slot;
+    uint i = slot;
+
+    for (;;) {
+        i = (i + 1U) & mask;
+        if (!row->keys[i]) {
+            break;
+        }
+        uint home = channel_dynamic_att_sparse_hash(row->keys[i] - 1U, row->capacity);
+        /* Leave the entry if its home slot lies cyclically in (hole, i] */
+        if ((hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i)) {
+            continue;
+        }
+        row->keys[hole] = row->keys[i];
+        row->values[hole] = row->values[i];
+        hole = i;
+    }
+    row->keys[hole] = 0U;
+    row->count--;
+}
+
+/*
+ * Get a sparse row for writing, emptying it first if it predates the last reset
+ */
+static ch_dynamic_att_sparse_row_t *channel_dynamic_att_sparse_row(uint rx)
+{
+    ch_dynamic_att_sparse_row_t *row = &ch_dynamic_att_matrix_prv.sparse_rows[rx];
+
+    if (!channel_dynamic_att_matrix_row_is_current(rx)) {
+        if (row->count) {
+            memset(row->keys, 0, row->capacity*sizeof(uint));
+            row->count = 0U;
+        }
+        ch_dynamic_att_matrix_prv.row_epoch[rx] = ch_dynamic_att_matrix_prv.epoch;
+    }
+    return row;
+}
+
+static void channel_dynamic_att_sparse_set(uint tx, uint rx, double attenuation)
+{
+    ch_dynamic_att_sparse_row_t *row = channel_dynamic_att_sparse_row(rx);
+    /* With groups every set link is an override, also when it equals the default attenuation */
+    bool is_default = !ch_dynamic_att_matrix_prv.num_groups && (attenuation == ch_dynamic_att_matrix_prv.default_attenuation);
+    uint slot;
+
+    if (row->count == 0U && is_default) {
+        return;
+    }
+    if (row->capacity && channel_dynamic_att_sparse_find(row, tx, &slot)) {
+        if (is_default) {
+            channel_dynamic_att_sparse_remove(row, slot);
+        } else {
+            row->values[slot] = attenuation;
+        }
+        return;
+    }
+    if (is_default) {
+        return;
+    }
+
+    /* Keep the load factor at or below 1/2 */
+    if ((row->count + 1U)*2U > row->capacity) {
+        channel_dynamic_att_sparse_grow(row);
+    }
+    channel_dynamic_att_sparse_find(row, tx, &slot);
+    row->keys[slot] = tx + 1U;
+    row->values[slot] = attenuation;
+    row->count++;
+}
+
+static void channel_dynamic_att_sparse_gather(uint rx, const uint *tx_used, double *att)
+{
+    const ch_dynamic_att_sparse_row_t *row = channel_dynamic_att_sparse_row(rx);
+    double default_attenuation = ch_dynamic_att_matrix_prv.default_attenuation;
+    uint slot;
+
+    for (uint tx = 0U; tx < ch_dynamic_att_matrix_prv.num_devices; tx++) {
+        if (tx_used[tx]) {
+            if (row->count && channel_dynamic_att_sparse_find(row, tx, &slot)) {
+                att[tx] = row->values[slot];
+            } else {
+                att[tx] = default_attenuation;
+            }
+        }
+    }
+}
+
+static void channel_dynamic_att_group_gather(uint rx, const uint *tx_used, double *att)
+{
+    const ch_dynamic_att_sparse_row_t *row = channel_dynamic_att_sparse_row(rx);
+    const unsigned char *device_group = ch_dynamic_att_matrix_prv.device_group;
+    const double *group_row = ch_dynamic_att_matrix_prv.group_matrix + device_group[rx]*ch_dynamic_att_matrix_prv.num_groups;
+    uint slot;
+
+    if (row->count == 0U) {
+        for (uint tx = 0U; tx < ch_dynamic_att_matrix_prv.num_devices; tx++) {
+            if (tx_used[tx]) {
+                att[tx] = group_row[device_group[tx]];
+            }
+        }
+        return;
+    }
+    for (uint tx = 0U; tx < ch_dynamic_att_matrix_prv.num_devices; tx++) {
+        if (tx_used[tx]) {
+            if (channel_dynamic_att_sparse_find(row, tx, &slot)) {
+                att[tx] = row->values[slot];
+            } else {
+                att[tx] = group_row[device_group[tx]];
+            }
+        }
+    }
+}
+
+static void channel_dynamic_att_group_clear(void)
+{
+    memset(ch_dynamic_att_matrix_prv.device_group, 0, ch_dynamic_att_matrix_prv.num_devices*sizeof(unsigned char));
+    for (uint i = 0U; i < ch_dynamic_att_matrix_prv.num_groups*ch_dynamic_att_matrix_prv.num_groups; i++) {
+        ch_dynamic_att_matrix_prv.group_matrix[i] = ch_dynamic_att_matrix_prv.default_attenuation;
+    }
+}
+
+/*
+ * Public API
+ */
+
+void channel_dynamic_att_matrix_init(uint num_devices, double default_attenuation, ch_dynamic_att_storage_t storage, uint num_groups,
+                                     uint num_bins)
+{
+    if (num_bins > 1U) {
+        /* Frequency bins are only kept in dense storage */
+        size_t size = (size_t)num_devices*num_devices*num_bins*sizeof(double);
+
+        if (num_groups || storage == DYNAMIC_ATT_STORAGE_SPARSE) {
+            bs_trace_error("channel: frequency bins cannot be used with groups or sparse storage\n");
+        }
+        if (size > DYNAMIC_ATT_FREQ_BINS_MAX_AUTO_SIZE) {
+            if (storage == DYNAMIC_ATT_STORAGE_AUTO) {
+                bs_trace_error("channel: %u devices with %u frequency bins need a %zu MiB dense matrix, give -st=dense to allow it\n",
+                               num_devices, num_bins, size >> 20);
+            }
+            if (storage == DYNAMIC_ATT_STORAGE_DENSE) {
+                bs_trace_warning_line("channel: %u devices with %u frequency bins allocate a %zu MiB dense matrix\n",
+                                      num_devices, num_bins, size >> 20);
+            }
+        }
+        if (storage == DYNAMIC_ATT_STORAGE_AUTO) {
+            storage = DYNAMIC_ATT_STORAGE_DENSE;
+        }
+    }
+    if (storage == DYNAMIC_ATT_STORAGE_SYMMETRIC && (num_groups || num_bins > 1U)) {
+        bs_trace_error("channel: symmetric storage cannot be used with groups or frequency bins\n");
+    }
+    if (num_groups) {
+        /* Overrides on top of the group matrix are only kept in sparse storage */
+        if (storage == DYNAMIC_ATT_STORAGE_DENSE) {
+            bs_trace_error("channel: groups cannot be used with dense storage\n");
+        }
+        storage = DYNAMIC_ATT_STORAGE_SPARSE;
+    } else if (storage == DYNAMIC_ATT_STORAGE_AUTO) {
+        storage = (num_devices > DYNAMIC_ATT_SPARSE_THRESHOLD) ? DYNAMIC_ATT_STORAGE_SPARSE : DYNAMIC_ATT_STORAGE_DENSE;
+    }
+
+    ch_dynamic_att_matrix_prv.storage = storage;
+    ch_dynamic_att_matrix_prv.default_attenuation = default_attenuation;
+    ch_dynamic_att_matrix_prv.num_devices = num_devices;
+    ch_dynamic_att_matrix_prv.num_groups = num_groups;
+    ch_dynamic_att_matrix_prv.num_bins = num_bins;
+    ch_dynamic_att_matrix_prv.row_size = (size_t)num_devices*num_bins;
+
+    if (num_groups) {
+        ch_dynamic_att_matrix_prv.device_group = bs_calloc(num_devices, sizeof(unsigned char));
+        ch_dynamic_att_matrix_prv.group_matrix = bs_calloc((size_t)num_groups*num_groups, sizeof(double));
+        if (!ch_dynamic_att_matrix_prv.device_group || !ch_dynamic_att_matrix_prv.group_matrix) {
+            bs_trace_error("Error allocating memory for attenuation groups");
+        }
+        channel_dynamic_att_group_clear();
+    }
+
+    /* All rows start out in epoch 0, so they read as default until first used */
+    ch_dynamic_att_matrix_prv.epoch = 1U;
+    ch_dynamic_att_matrix_prv.row_epoch = bs_calloc(num_devices, sizeof(uint));
+    if (!ch_dynamic_att_matrix_prv.row_epoch) {
+        bs_trace_error("Error allocating memory for attenuation matrix epochs");
+    }
+
+    if (storage == DYNAMIC_ATT_STORAGE_SPARSE) {
+        ch_dynamic_att_matrix_prv.sparse_rows = bs_calloc(num_devices, sizeof(ch_dynamic_att_sparse_row_t));
+        if (!ch_dynamic_att_matrix_prv.sparse_rows) {
+            bs_trace_error("Error allocating memory for sparse attenuation matrix");
+        }
+    } else if (storage == DYNAMIC_ATT_STORAGE_SYMMETRIC) {
+        ch_dynamic_att_matrix_prv.row_offset = bs_calloc(num_devices, sizeof(size_t));
+        ch_dynamic_att_matrix_prv.attenuation_matrix = bs_calloc((size_t)num_devices*(num_devices + 1U)/2U, sizeof(double));
+        if (!ch_dynamic_att_matrix_prv.row_offset || !ch_dynamic_att_matrix_prv.attenuation_matrix) {
+            bs_trace_error("Error allocating memory for symmetric attenuation matrix");
+        }
+        /* Row i starts after the N - k entries of every row k < i, and is indexed from column i */
+        for (uint i = 0U; i < num_devices; i++) {
+            ch_dynamic_att_matrix_prv.row_offset[i] = (size_t)i*num_devices - (size_t)i*(i + 1U)/2U;
+        }
+    } else {
+        ch_dynamic_att_matrix_prv.attenuation_matrix = bs_calloc(num_devices*ch_dynamic_att_matrix_prv.row_size, sizeof(double));
+        if (!ch_dynamic_att_matrix_prv.attenuation_matrix) {
+            bs_trace_error("Error allocating memory for attenuation matrix");
+        }
+    }
+    channel_dynamic_att_gather_init();
+
+    bs_trace_raw(8, "channel_dynamic_att using %s storage, %u groups, %u frequency bins and %s gather kernel\n",
+                 storage == DYNAMIC_ATT_STORAGE_SPARSE ? "sparse" : (storage == DYNAMIC_ATT_STORAGE_SYMMETRIC ? "symmetric" : "dense"),
+                 num_groups, num_bins, channel_dynamic_att_gather_kernel_name());
+}
+
+void channel_dynamic_att_matrix_delete(void)
+{
+    if (ch_dynamic_att_matrix_prv.attenuation_matrix) {
+        free(ch_dynamic_att_matrix_prv.attenuation_matrix);
+        ch_dynamic_att_matrix_prv.attenuation_matrix = NULL;
+    }
+    if (ch_dynamic_att_matrix_prv.sparse_rows) {
+        for (uint rx = 0U; rx < ch_dynamic_att_matrix_prv.num_devices; rx++) {
+            free(ch_dynamic_att_matrix_prv.sparse_rows[rx].keys);
+            free(ch_dynamic_att_matrix_prv.sparse_rows[rx].values);
+        }
+        free(ch_dynamic_att_matrix_prv.sparse_rows);
+        ch_dynamic_att_matrix_prv.sparse_rows = NULL;
+    }
+    if (ch_dynamic_att_matrix_prv.row_offset) {
+        free(ch_dynamic_att_matrix_prv.row_offset);
+        ch_dynamic_att_matrix_prv.row_offset = NULL;
+    }
+    if (ch_dynamic_att_matrix_prv.row_epoch) {
+        free(ch_dynamic_att_matrix_prv.row_epoch);
+        ch_dynamic_att_matrix_prv.row_epoch = NULL;
+    }
+    if (ch_dynamic_att_matrix_prv.device_group) {
+        free(ch_dynamic_att_matrix_prv.device_group);
+        ch_dynamic_att_matrix_prv.device_group = NULL;
+    }
+    if (ch_dynamic_att_matrix_prv.group_matrix) {
+        free(ch_dynamic_att_matrix_prv.group_matrix);
+        ch_dynamic_att_matrix_prv.group_matrix = NULL;
+    }
+}
+
+bool channel_dynamic_att_matrix_is_symmetric(void)
+{
+    return ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_SYMMETRIC;
+}
+
+void channel_dynamic_att_matrix_reset(void)
+{
+    if (++ch_dynamic_att_matrix_prv.epoch == 0U) {
+        /* Epoch counter wrapped, restart it so no row can look current by accident */
+        memset(ch_dynamic_att_matrix_prv.row_epoch, 0, ch_dynamic_att_matrix_prv.num_devices*sizeof(uint));
+        ch_dynamic_att_matrix_prv.epoch = 1U;
+    }
+    if (ch_dynamic_att_matrix_prv.num_groups) {
+        channel_dynamic_att_group_clear();
+    }
+}
+
+void channel_dynamic_att_matrix_set(uint tx, uint rx, double attenuation)
+{
+    double *row;
+
+    if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_SPARSE) {
+        channel_dynamic_att_sparse_set(tx, rx, attenuation);
+    } else if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_SYMMETRIC) {
+        if (tx < rx) {
+            channel_dynamic_att_symmetric_row(tx)[rx] = attenuation;
+        } else {
+            channel_dynamic_att_symmetric_row(rx)[tx] = attenuation;
+        }
+    } else if (ch_dynamic_att_matrix_prv.num_bins == 1U) {
+        channel_dynamic_att_dense_row(rx)[tx] = attenuation;
+    } else {
+        row = channel_dynamic_att_dense_row(rx) + (size_t)tx*ch_dynamic_att_matrix_prv.num_bins;
+        for (uint bin = 0U; bin < ch_dynamic_att_matrix_prv.num_bins; bin++) {
+            row[bin] = attenuation;
+        }
+    }
+}
+
+void channel_dynamic_att_matrix_set_bin(uint tx, uint rx, uint bin, double attenuation)
+{
+    if (ch_dynamic_att_matrix_prv.storage != DYNAMIC_ATT_STORAGE_DENSE) {
+        /* Only dense storage has more than one bin */
+        channel_dynamic_att_matrix_set(tx, rx, attenuation);
+    } else {
+        channel_dynamic_att_dense_row(rx)[(size_t)tx*ch_dynamic_att_matrix_prv.num_bins + bin] = attenuation;
+    }
+}
+
+void channel_dynamic_att_matrix_gather(uint rx, const uint *tx_used, double *att)
+{
+    if (ch_dynamic_att_matrix_prv.num_groups) {
+        channel_dynamic_att_group_gather(rx, tx_used, att);
+    } else if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_SPARSE) {
+        channel_dynamic_att_sparse_gather(rx, tx_used, att);
+    } else if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_SYMMETRIC) {
+        channel_dynamic_att_symmetric_gather(rx, tx_used, att);
+    } else {
+        channel_dynamic_att_gather(channel_dynamic_att_dense_row(rx), tx_used, ch_dynamic_att_matrix_prv.num_devices, att);
+    }
+}
+
+const double *channel_dynamic_att_matrix_bin_row(uint rx)
+{
+    return channel_dynamic_att_dense_row(rx);
+}
+
+uint channel_dynamic_att_matrix_num_bins(void)
+{
+    return ch_dynamic_att_matrix_prv.num_bins;
+}
+
+uint channel_dynamic_att_matrix_num_groups(void)
+{
+    return ch_dynamic_att_matrix_prv.num_groups;
+}
+
+void channel_dynamic_att_matrix_set_group(uint device, uint group)
+{
+    ch_dynamic_att_matrix_prv.device_group[device] = (unsigned char)group;
+}
+
+void channel_dynamic_att_matrix_set_group_att(uint tx_group, uint rx_group, double attenuation)
+{
+    ch_dynamic_att_matrix_prv.group_matrix[rx_group*ch_dynamic_att_matrix_prv.num_groups + tx_group] = attenuation;
+}
+
+void channel_dynamic_att_matrix_load(const double *matrix)
+{
+    uint num_devices = ch_dynamic_att_matrix_prv.num_devices;
+
+    if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_DENSE) {
+        memcpy(ch_dynamic_att_matrix_prv.attenuation_matrix, matrix, (size_t)num_devices*num_devices*sizeof(double));
+        for (uint rx = 0U; rx < num_devices; rx++) {
+            ch_dynamic_att_matrix_prv.row_epoch[rx] = ch_dynamic_att_matrix_prv.epoch;
+        }
+        return;
+    }
+    if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_SYMMETRIC) {
+        uint asymmetric = 0U;
+
+        for (uint rx = 0U; rx < num_devices; rx++) {
+            double *row = channel_dynamic_att_symmetric_row(rx);
+
+            for (uint tx = rx + 1U; tx < num_devices; tx++) {
+                row[tx] = matrix[(size_t)rx*num_devices + tx];
+                asymmetric += (row[tx] != matrix[(size_t)tx*num_devices + rx]);
+            }
+        }
+        if (asymmetric) {
+            bs_trace_warning_line("%u links of the snapshot differ per direction, symmetric storage keeps the attenuation "
+                                  "from the higher numbered device\n", asymmetric);
+        }
+        return;
+    }
+
+    for (uint rx = 0U; rx < num_devices; rx++) {
+        const double *row = matrix + (size_t)rx*num_devices;
+
+        for (uint tx = 0U; tx < num_devices; tx++) {
+            if (tx != rx && row[tx] != ch_dynamic_att_matrix_prv.default_attenuation) {
+                channel_dynamic_att_sparse_set(tx, rx, row[tx]);
+            }
+        }
+    }
+}
+
+void channel_dynamic_att_matrix_copy_row(uint rx, double *row)
+{
+    const ch_dynamic_att_sparse_row_t *sparse_row;
+
+    if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_DENSE) {
+        memcpy(row, channel_dynamic_att_dense_row(rx), ch_dynamic_att_matrix_prv.num_devices*sizeof(double));
+        return;
+    }
+    if (ch_dynamic_att_matrix_prv.storage == DYNAMIC_ATT_STORAGE_SYMMETRIC) {
+        for (uint tx = 0U; tx < ch_dynamic_att_matrix_prv.num_devices; tx++) {
+            row[tx] = channel_dynamic_att_symmetric_get(tx, rx);
+        }
+        return;
+    }
+
+    for (uint tx = 0U; tx < ch_dynamic_att_matrix_prv.num_devices; tx++) {
+        row[tx] = channel_dynamic_att_matrix_fallback(tx, rx);
+    }
+    sparse_row = channel_dynamic_att_sparse_row(rx);
+    if (sparse_row->count) {
+        for (uint slot = 0U; slot < sparse_row->capacity; slot++) {
+            if (sparse_row->keys[slot]) {
+                row[sparse_row->keys[slot] - 1U] = sparse_row->values[slot];
+            }
+        }
+    }
+}
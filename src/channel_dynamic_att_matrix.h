@@ -0,0 +1,125 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_MATRIX_H
+#define _CHANNEL_DYNAMIC_ATT_MATRIX_H
+
+#include "bs_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DYNAMIC_ATT_STORAGE_AUTO = 0, /* Dense below DYNAMIC_ATT_SPARSE_THRESHOLD devices, sparse above */
+    DYNAMIC_ATT_STORAGE_DENSE,    /* Full NxN matrix */
+    DYNAMIC_ATT_STORAGE_SPARSE,   /* Only links that differ from the default attenuation */
+    DYNAMIC_ATT_STORAGE_SYMMETRIC,/* Packed upper triangle, one attenuation for both directions of a link */
+} ch_dynamic_att_storage_t;
+
+/**
+ * @brief Allocate the attenuation storage with all links set to the default attenuation
+ *
+ * @param num_devices Number of devices in the simulation
+ * @param default_attenuation Attenuation of links that have not been set
+ * @param storage Requested storage mode
+ * @param num_groups Number of groups, or 0 to not use groups. Groups require sparse storage.
+ * @param num_bins Number of frequency bins, 1 for a single attenuation per link. More bins require dense storage.
+ *
+ * With symmetric storage setting either direction of a link sets both.
+ */
+void channel_dynamic_att_matrix_init(uint num_devices, double default_attenuation, ch_dynamic_att_storage_t storage, uint num_groups,
+                                     uint num_bins);
+
+/**
+ * @brief Free the attenuation storage
+ */
+void channel_dynamic_att_matrix_delete(void);
+
+/**
+ * @brief True if both directions of a link share one attenuation
+ */
+bool channel_dynamic_att_matrix_is_symmetric(void);
+
+/**
+ * @brief Set all links back to the default attenuation
+ *
+ * With groups this also moves all devices back to group 0 and drops all per link overrides.
+ */
+void channel_dynamic_att_matrix_reset(void);
+
+/**
+ * @brief Set the attenuation for packets sent from tx to rx, in all frequency bins
+ */
+void channel_dynamic_att_matrix_set(uint tx, uint rx, double attenuation);
+
+/**
+ * @brief Set the attenuation for packets sent from tx to rx in one frequency bin
+ */
+void channel_dynamic_att_matrix_set_bin(uint tx, uint rx, uint bin, double attenuation);
+
+/**
+ * @brief Copy the attenuation from every active transmitter to rx
+ *
+ * @param rx      The receiving device
+ * @param tx_used Array with num_devices elements, non-zero for active transmitters
+ * @param att     Array with num_devices elements. Only the elements of active transmitters are written.
+ */
+void channel_dynamic_att_matrix_gather(uint rx, const uint *tx_used, double *att);
+
+/**
+ * @brief Number of frequency bins, 1 if frequency bins are not used
+ */
+uint channel_dynamic_att_matrix_num_bins(void);
+
+/**
+ * @brief Attenuation from every device to rx in every frequency bin. Dense storage only.
+ *
+ * @param rx The receiving device
+ * @return num_devices*num_bins attenuations, the entry for tx in bin b at tx*num_bins + b
+ */
+const double *channel_dynamic_att_matrix_bin_row(uint rx);
+
+/**
+ * @brief Number of groups, 0 if groups are not used
+ */
+uint channel_dynamic_att_matrix_num_groups(void);
+
+/**
+ * @brief Move a device to a group
+ *
+ * Links of the device which have not been set individually follow the group matrix of the new group.
+ */
+void channel_dynamic_att_matrix_set_group(uint device, uint group);
+
+/**
+ * @brief Set the attenuation for packets sent from devices in tx_group to devices in rx_group
+ */
+void channel_dynamic_att_matrix_set_group_att(uint tx_group, uint rx_group, double attenuation);
+
+/**
+ * @brief Set all links from a full Rx-major NxN matrix
+ *
+ * With dense storage this is a single copy. With sparse storage only links which differ from the
+ * default attenuation are stored. With symmetric storage the upper triangle (tx > rx) is used.
+ * Not supported with groups.
+ *
+ * @param matrix num_devices*num_devices attenuations, the entry for tx to rx at rx*num_devices + tx
+ */
+void channel_dynamic_att_matrix_load(const double *matrix);
+
+/**
+ * @brief Copy the attenuation from every device to rx
+ *
+ * @param rx  The receiving device
+ * @param row Array with num_devices elements
+ */
+void channel_dynamic_att_matrix_copy_row(uint rx, double *row);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_MATRIX_H */
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_matrix.h"
+#include "channel_dynamic_att_position.h"
+
+/*
+ * Attenuation computed from positions is cached in the attenuation matrix, and only recomputed
+ * for rows which are looked up.
+ *
+ * Every move (or offset change) of a device gets the next number of a global move counter and is
+ * appended to a move log, a ring holding the last num_devices moves. Each Rx row remembers the
+ * move counter it was last refreshed at. Refreshing a row then recomputes the links from the
+ * devices in the log after that point, or the whole row if the receiver itself moved. When the log
+ * no longer reaches back that far, the devices which moved are found by their last move instead.
+ * A move therefore costs O(1), and a lookup costs O(moves since the last lookup of that receiver).
+ *
+ * Links where one of the devices has no position keep the attenuation set by the clients.
+ */
+
+/* Free space path loss in dB at 1 m and 2440 MHz: 20*log10(4*pi*f/c) */
+#define DYNAMIC_ATT_PATHLOSS_FSPL_1M (40.2)
+
+typedef struct {
+    double x;
+    double y;
+    double z;
+} ch_dynamic_att_position_t;
+
+static struct {
+    ch_dynamic_att_pathloss_t  pathloss;
+    uint                       num_devices;
+    double                     exponent;
+    double                     d0_squared;
+    double                     loss0;
+
+    ch_dynamic_att_position_t *position;
+    bool                      *has_position;
+    double                    *offset;
+    uint64_t                  *device_moved;  /* Move counter of the last move of each device */
+    uint64_t                  *row_refreshed; /* Move counter each Rx row was last refreshed at */
+    uint                      *move_log;      /* Device of move number n at n % num_devices */
+    uint64_t                   move_count;
+} ch_dynamic_att_position_prv = {0};
+
+static double channel_dynamic_att_position_loss(uint tx, uint rx)
+{
+    const ch_dynamic_att_position_t *a = &ch_dynamic_att_position_prv.position[tx];
+    const ch_dynamic_att_position_t *b = &ch_dynamic_att_position_prv.position[rx];
+    double d_squared = (a->x - b->x)*(a->x - b->x) + (a->y - b->y)*(a->y - b->y) + (a->z - b->z)*(a->z - b->z);
+    double loss = ch_dynamic_att_position_prv.loss0;
+
+    if (d_squared > ch_dynamic_att_position_prv.d0_squared) {
+        /* 10*n*log10(d/d0) without the square root */
+        loss += 5.0*ch_dynamic_att_position_prv.exponent*log10(d_squared/ch_dynamic_att_position_prv.d0_squared);
+    }
+    return loss + ch_dynamic_att_position_prv.offset[tx] + ch_dynamic_att_position_prv.offset[rx];
+}
+
+static void channel_dynamic_att_position_update_link(uint tx, uint rx)
+{
+    if (tx != rx && ch_dynamic_att_position_prv.has_position[tx]) {
+        channel_dynamic_att_matrix_set(tx, rx, channel_dynamic_att_position_loss(tx, rx));
+    }
+}
+
+static void channel_dynamic_att_position_moved(uint device)
+{
+    ch_dynamic_att_position_prv.move_log[ch_dynamic_att_position_prv.move_count % ch_dynamic_att_position_prv.num_devices] = device;
+    ch_dynamic_att_position_prv.device_moved[device] = ++ch_dynamic_att_position_prv.move_count;
+}
+
+/*
+ * Public API
+ */
+
+void channel_dynamic_att_position_init(uint num_devices, ch_dynamic_att_pathloss_t pathloss, double exponent, double d0, double loss0)
+{
+    ch_dynamic_att_position_prv.pathloss = pathloss;
+    ch_dynamic_att_position_prv.num_devices = num_devices;
+    if (pathloss == DYNAMIC_ATT_PATHLOSS_FSPL) {
+        exponent = 2.0;
+        loss0 = DYNAMIC_ATT_PATHLOSS_FSPL_1M + 20.0*log10(d0);
+    }
+    ch_dynamic_att_position_prv.exponent = exponent;
+    ch_dynamic_att_position_prv.d0_squared = d0*d0;
+    ch_dynamic_att_position_prv.loss0 = loss0;
+
+    ch_dynamic_att_position_prv.position = bs_calloc(num_devices, sizeof(ch_dynamic_att_position_t));
+    ch_dynamic_att_position_prv.has_position = bs_calloc(num_devices, sizeof(bool));
+    ch_dynamic_att_position_prv.offset = bs_calloc(num_devices, sizeof(double));
+    ch_dynamic_att_position_prv.device_moved = bs_calloc(num_devices, sizeof(uint64_t));
+    ch_dynamic_att_position_prv.row_refreshed = bs_calloc(num_devices, sizeof(uint64_t));
+    ch_dynamic_att_position_prv.move_log = bs_calloc(num_devices, sizeof(uint));
+    if (!ch_dynamic_att_position_prv.position || !ch_dynamic_att_position_prv.has_position || !ch_dynamic_att_position_prv.offset ||
+        !ch_dynamic_att_position_prv.device_moved || !ch_dynamic_att_position_prv.row_refreshed || !ch_dynamic_att_position_prv.move_log) {
+        bs_trace_error("Error allocating memory for device positions");
+    }
+
+    bs_trace_raw(8, "channel_dynamic_att computing attenuation from positions, %.1lf dB at %.2lf m plus %.1lf dB per decade\n",
+                 loss0, d0, 10.0*exponent);
+}
+
+void channel_dynamic_att_position_delete(void)
+{
+    free(ch_dynamic_att_position_prv.position);
+    free(ch_dynamic_att_position_prv.has_position);
+    free(ch_dynamic_att_position_prv.offset);
+    free(ch_dynamic_att_position_prv.device_moved);
+    free(ch_dynamic_att_position_prv.row_refreshed);
+    free(ch_dynamic_att_position_prv.move_log);
+    memset(&ch_dynamic_att_position_prv, 0, sizeof(ch_dynamic_att_position_prv));
+}
+
+bool channel_dynamic_att_position_is_enabled(void)
+{
+    return ch_dynamic_att_position_prv.pathloss != DYNAMIC_ATT_PATHLOSS_NONE;
+}
+
+void channel_dynamic_att_position_reset(void)
+{
+    uint num_devices = ch_dynamic_att_position_prv.num_devices;
+
+    memset(ch_dynamic_att_position_prv.has_position, 0, num_devices*sizeof(bool));
+    memset(ch_dynamic_att_position_prv.offset, 0, num_devices*sizeof(double));
+    /* The matrix is back at the default, so no row has anything left to refresh */
+    for (uint rx = 0U; rx < num_devices; rx++) {
+        ch_dynamic_att_position_prv.row_refreshed[rx] = ch_dynamic_att_position_prv.move_count;
+    }
+}
+
+void channel_dynamic_att_position_set(uint device, double x, double y, double z)
+{
+    ch_dynamic_att_position_prv.position[device].x = x;
+    ch_dynamic_att_position_prv.position[device].y = y;
+    ch_dynamic_att_position_prv.position[device].z = z;
+    ch_dynamic_att_position_prv.has_position[device] = true;
+    channel_dynamic_att_position_moved(device);
+}
+
+void channel_dynamic_att_position_set_offset(uint device, double offset)
+{
+    ch_dynamic_att_position_prv.offset[device] = offset;
+    if (ch_dynamic_att_position_prv.has_position[device]) {
+        channel_dynamic_att_position_moved(device);
+    }
+}
+
+void channel_dynamic_att_position_refresh(uint rx)
+{
+    uint64_t refreshed = ch_dynamic_att_position_prv.row_refreshed[rx];
+    uint64_t move_count = ch_dynamic_att_position_prv.move_count;
+    uint num_devices = ch_dynamic_att_position_prv.num_devices;
+
+    if (refreshed == move_count) {
+        return;
+    }
+    ch_dynamic_att_position_prv.row_refreshed[rx] = move_count;
+    if (!ch_dynamic_att_position_prv.has_position[rx]) {
+        return;
+    }
+
+    if (ch_dynamic_att_position_prv.device_moved[rx] > refreshed) {
+        for (uint tx = 0U; tx < num_devices; tx++) {
+            channel_dynamic_att_position_update_link(tx, rx);
+        }
+        return;
+    }
+    if (move_count - refreshed > num_devices) {
+        /* The log does not reach back far enough, find the devices which moved instead */
+        for (uint tx = 0U; tx < num_devices; tx++) {
+            if (ch_dynamic_att_position_prv.device_moved[tx] > refreshed) {
+                channel_dynamic_att_position_update_link(tx, rx);
+            }
+        }
+        return;
+    }
+    for (uint64_t move = refreshed; move < move_count; move++) {
+        channel_dynamic_att_position_update_link(ch_dynamic_att_position_prv.move_log[move % num_devices], rx);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_POSITION_H
+#define _CHANNEL_DYNAMIC_ATT_POSITION_H
+
+#include "bs_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DYNAMIC_ATT_PATHLOSS_NONE = 0, /* Attenuation is only set by the clients */
+    DYNAMIC_ATT_PATHLOSS_FSPL,     /* Free space path loss at 2440 MHz */
+    DYNAMIC_ATT_PATHLOSS_LOGDIST,  /* Log-distance path loss: loss0 + 10*exponent*log10(d/d0) */
+} ch_dynamic_att_pathloss_t;
+
+/**
+ * @brief Enable attenuation from device positions
+ *
+ * @param num_devices Number of devices in the simulation
+ * @param pathloss Path loss model
+ * @param exponent Path loss exponent of the log-distance model
+ * @param d0 Reference distance in meters. Devices closer than this have the loss at d0.
+ * @param loss0 Path loss in dB at d0 of the log-distance model
+ */
+void channel_dynamic_att_position_init(uint num_devices, ch_dynamic_att_pathloss_t pathloss, double exponent, double d0, double loss0);
+
+/**
+ * @brief Free the position state, if any
+ */
+void channel_dynamic_att_position_delete(void);
+
+/**
+ * @brief True if attenuation is computed from device positions
+ */
+bool channel_dynamic_att_position_is_enabled(void);
+
+/**
+ * @brief Forget all positions and offsets
+ *
+ * To be called together with @ref channel_dynamic_att_matrix_reset.
+ */
+void channel_dynamic_att_position_reset(void);
+
+/**
+ * @brief Move a device. Its links are recomputed when they are next looked up.
+ *
+ * @param device The device
+ * @param x, y, z Position in meters
+ */
+void channel_dynamic_att_position_set(uint device, double x, double y, double z);
+
+/**
+ * @brief Set the attenuation in dB added to all computed links to and from a device
+ */
+void channel_dynamic_att_position_set_offset(uint device, double offset);
+
+/**
+ * @brief Recompute the links to rx whose devices moved since rx was last looked up
+ *
+ * Must be called before reading the attenuation to rx from the matrix.
+ */
+void channel_dynamic_att_position_refresh(uint rx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_POSITION_H */
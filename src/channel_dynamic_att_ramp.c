@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_ramp.h"
+
+/*
+ * Active ramps are kept in a small unordered table, which is scanned when a receiver is looked
+ * up. Scenarios only have a handful of ramps running at any time, and a ramp leaves the table as
+ * soon as it has ended: its end attenuation is then written to the attenuation matrix, so links
+ * cost nothing extra once their ramp is done.
+ */
+
+typedef struct {
+    uint      tx;
+    uint      rx;
+    double    start_attenuation;
+    double    end_attenuation;
+    bs_time_t start_time;
+    bs_time_t end_time;
+} ch_dynamic_att_ramp_t;
+
+static struct {
+    ch_dynamic_att_ramp_t *ramps;
+    uint                   count;
+    uint                   capacity;
+} ch_dynamic_att_ramp_prv = {0};
+
+static void channel_dynamic_att_ramp_remove(uint index)
+{
+    ch_dynamic_att_ramp_prv.ramps[index] = ch_dynamic_att_ramp_prv.ramps[--ch_dynamic_att_ramp_prv.count];
+}
+
+static double channel_dynamic_att_ramp_value(const ch_dynamic_att_ramp_t *ramp, bs_time_t now)
+{
+    if (now <= ramp->start_time) {
+        return ramp->start_attenuation;
+    }
+    if (now >= ramp->end_time) {
+        return ramp->end_attenuation;
+    }
+    return ramp->start_attenuation + (ramp->end_attenuation - ramp->start_attenuation)*
+                                     (double)(now - ramp->start_time)/(double)(ramp->end_time - ramp->start_time);
+}
+
+void channel_dynamic_att_ramp_add(uint tx, uint rx, double start_attenuation, double end_attenuation, bs_time_t start_time, bs_time_t end_time)
+{
+    ch_dynamic_att_ramp_t *ramp;
+
+    channel_dynamic_att_ramp_cancel(tx, rx, start_time, NULL);
+    if (ch_dynamic_att_ramp_prv.count == ch_dynamic_att_ramp_prv.capacity) {
+        ch_dynamic_att_ramp_prv.capacity = ch_dynamic_att_ramp_prv.capacity ? ch_dynamic_att_ramp_prv.capacity*2U : 16U;
+        ch_dynamic_att_ramp_prv.ramps = bs_realloc(ch_dynamic_att_ramp_prv.ramps, ch_dynamic_att_ramp_prv.capacity*sizeof(ch_dynamic_att_ramp_t));
+        if (!ch_dynamic_att_ramp_prv.ramps) {
+            bs_trace_error("Error allocating memory for attenuation ramps");
+        }
+    }
+
+    ramp = &ch_dynamic_att_ramp_prv.ramps[ch_dynamic_att_ramp_prv.count++];
+    ramp->tx = tx;
+    ramp->rx = rx;
+    ramp->start_attenuation = start_attenuation;
+    ramp->end_attenuation = end_attenuation;
+    ramp->start_time = start_time;
+    ramp->end_time = end_time;
+}
+
+bool channel_dynamic_att_ramp_cancel(uint tx, uint rx, bs_time_t now, double *attenuation)
+{
+    for (uint i = 0U; i < ch_dynamic_att_ramp_prv.count; i++) {
+        if (ch_dynamic_att_ramp_prv.ramps[i].tx == tx && ch_dynamic_att_ramp_prv.ramps[i].rx == rx) {
+            /* There is at most one ramp per link */
+            if (attenuation) {
+                *attenuation = channel_dynamic_att_ramp_value(&ch_dynamic_att_ramp_prv.ramps[i], now);
+            }
+            channel_dynamic_att_ramp_remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint channel_dynamic_att_ramp_count(void)
+{
+    return ch_dynamic_att_ramp_prv.count;
+}
+
+bool channel_dynamic_att_ramp_next_done(bs_time_t now, uint *tx, uint *rx, double *attenuation)
+{
+    for (uint i = 0U; i < ch_dynamic_att_ramp_prv.count; i++) {
+        const ch_dynamic_att_ramp_t *ramp = &ch_dynamic_att_ramp_prv.ramps[i];
+
+        if (now >= ramp->end_time) {
+            *tx = ramp->tx;
+            *rx = ramp->rx;
+            *attenuation = ramp->end_attenuation;
+            channel_dynamic_att_ramp_remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void channel_dynamic_att_ramp_gather(uint rx, const uint *tx_used, bs_time_t now, double *att)
+{
+    for (uint i = 0U; i < ch_dynamic_att_ramp_prv.count; i++) {
+        const ch_dynamic_att_ramp_t *ramp = &ch_dynamic_att_ramp_prv.ramps[i];
+
+        if (ramp->rx == rx && tx_used[ramp->tx]) {
+            att[ramp->tx] = channel_dynamic_att_ramp_value(ramp, now);
+        }
+    }
+}
+
+void channel_dynamic_att_ramp_reset(void)
+{
+    ch_dynamic_att_ramp_prv.count = 0U;
+}
+
+void channel_dynamic_att_ramp_delete(void)
+{
+    free(ch_dynamic_att_ramp_prv.ramps);
+    ch_dynamic_att_ramp_prv.ramps = NULL;
+    ch_dynamic_att_ramp_prv.count = 0U;
+    ch_dynamic_att_ramp_prv.capacity = 0U;
+}
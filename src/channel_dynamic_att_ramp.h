@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_RAMP_H
+#define _CHANNEL_DYNAMIC_ATT_RAMP_H
+
+#include "bs_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start a linear ramp of the attenuation from tx to rx
+ *
+ * The link has start_attenuation until start_time, then changes linearly to end_attenuation at
+ * end_time. A ramp already active on the link is replaced.
+ */
+void channel_dynamic_att_ramp_add(uint tx, uint rx, double start_attenuation, double end_attenuation, bs_time_t start_time, bs_time_t end_time);
+
+/**
+ * @brief Stop the ramp of the link from tx to rx, if any
+ *
+ * @param tx, rx The link
+ * @param now Current simulation time
+ * @param attenuation If not NULL, set to the attenuation the ramp had reached at <now>
+ * @return True if the link had a ramp
+ */
+bool channel_dynamic_att_ramp_cancel(uint tx, uint rx, bs_time_t now, double *attenuation);
+
+/**
+ * @brief Number of active ramps
+ */
+uint channel_dynamic_att_ramp_count(void);
+
+/**
+ * @brief Take the next ramp which has ended at <now>
+ *
+ * @param now Current simulation time
+ * @param tx, rx Set to the link of the ramp
+ * @param attenuation Set to the end attenuation of the ramp, to be stored as the attenuation of the link
+ * @return False if no ramp has ended
+ */
+bool channel_dynamic_att_ramp_next_done(bs_time_t now, uint *tx, uint *rx, double *attenuation);
+
+/**
+ * @brief Overwrite the attenuation of active transmitters which have a ramp towards rx
+ *
+ * @param rx      The receiving device
+ * @param tx_used Array with num_devices elements, non-zero for active transmitters
+ * @param now     Current simulation time
+ * @param att     Array with num_devices elements
+ */
+void channel_dynamic_att_ramp_gather(uint rx, const uint *tx_used, bs_time_t now, double *att);
+
+/**
+ * @brief Drop all ramps
+ */
+void channel_dynamic_att_ramp_reset(void);
+
+/**
+ * @brief Drop all ramps and free the ramp table
+ */
+void channel_dynamic_att_ramp_delete(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_RAMP_H */
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_sched.h"
+
+/*
+ * Scheduled commands are kept in a binary min-heap ordered by apply time.
+ * Ties are broken by the order the commands were added, so commands scheduled for the same
+ * time are applied in the order they were received.
+ */
+
+#define DYNAMIC_ATT_SCHED_MIN_CAPACITY (64U)
+
+typedef struct {
+    bs_time_t                             apply_time;
+    uint64_t                              order;
+    ch_dynamic_att_com_protocol_packet_t *packet;
+} ch_dynamic_att_sched_entry_t;
+
+static struct {
+    ch_dynamic_att_sched_entry_t         *heap;
+    size_t                                count;
+    size_t                                capacity;
+    uint64_t                              next_order;
+    ch_dynamic_att_com_protocol_packet_t *returned;
+} ch_dynamic_att_sched_prv = {0};
+
+static bool channel_dynamic_att_sched_before(const ch_dynamic_att_sched_entry_t *a, const ch_dynamic_att_sched_entry_t *b)
+{
+    return (a->apply_time < b->apply_time) || (a->apply_time == b->apply_time && a->order < b->order);
+}
+
+static void channel_dynamic_att_sched_swap(size_t a, size_t b)
+{
+    ch_dynamic_att_sched_entry_t tmp = ch_dynamic_att_sched_prv.heap[a];
+
+    ch_dynamic_att_sched_prv.heap[a] = ch_dynamic_att_sched_prv.heap[b];
+    ch_dynamic_att_sched_prv.heap[b] = tmp;
+}
+
+static void channel_dynamic_att_sched_sift_up(size_t i)
+{
+    while (i > 0U) {
+        size_t parent = (i - 1U)/2U;
+
+        if (!channel_dynamic_att_sched_before(&ch_dynamic_att_sched_prv.heap[i], &ch_dynamic_att_sched_prv.heap[parent])) {
+            break;
+        }
+        channel_dynamic_att_sched_swap(i, parent);
+        i = parent;
+    }
+}
+
+static void channel_dynamic_att_sched_sift_down(size_t i)
+{
+    for (;;) {
+        size_t first = i;
+        size_t left = 2U*i + 1U;
+        size_t right = left + 1U;
+
+        if (left < ch_dynamic_att_sched_prv.count &&
+            channel_dynamic_att_sched_before(&ch_dynamic_att_sched_prv.heap[left], &ch_dynamic_att_sched_prv.heap[first])) {
+            first = left;
+        }
+        if (right < ch_dynamic_att_sched_prv.count &&
+            channel_dynamic_att_sched_before(&ch_dynamic_att_sched_prv.heap[right], &ch_dynamic_att_sched_prv.heap[first])) {
+            first = right;
+        }
+        if (first == i) {
+            break;
+        }
+        channel_dynamic_att_sched_swap(i, first);
+        i = first;
+    }
+}
+
+void channel_dynamic_att_sched_add(bs_time_t apply_time, const ch_dynamic_att_com_protocol_packet_t *packet)
+{
+    size_t packet_size = sizeof(packet->header) + packet->header.payload_size;
+    ch_dynamic_att_sched_entry_t *entry;
+
+    if (ch_dynamic_att_sched_prv.count == ch_dynamic_att_sched_prv.capacity) {
+        ch_dynamic_att_sched_prv.capacity = ch_dynamic_att_sched_prv.capacity ? ch_dynamic_att_sched_prv.capacity*2U : DYNAMIC_ATT_SCHED_MIN_CAPACITY;
+        ch_dynamic_att_sched_prv.heap = bs_realloc(ch_dynamic_att_sched_prv.heap, ch_dynamic_att_sched_prv.capacity*sizeof(ch_dynamic_att_sched_entry_t));
+        if (!ch_dynamic_att_sched_prv.heap) {
+            bs_trace_error("Error allocating memory for scheduled commands");
+        }
+    }
+
+    entry = &ch_dynamic_att_sched_prv.heap[ch_dynamic_att_sched_prv.count];
+    entry->apply_time = apply_time;
+    entry->order = ch_dynamic_att_sched_prv.next_order++;
+    entry->packet = bs_malloc(packet_size);
+    if (!entry->packet) {
+        bs_trace_error("Error allocating memory for scheduled command");
+    }
+    memcpy(entry->packet, packet, packet_size);
+
+    channel_dynamic_att_sched_sift_up(ch_dynamic_att_sched_prv.count++);
+}
+
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_sched_next(bs_time_t now, bs_time_t *apply_time)
+{
+    if (ch_dynamic_att_sched_prv.returned) {
+        free(ch_dynamic_att_sched_prv.returned);
+        ch_dynamic_att_sched_prv.returned = NULL;
+    }
+
+    if (ch_dynamic_att_sched_prv.count == 0U || ch_dynamic_att_sched_prv.heap[0].apply_time > now) {
+        return NULL;
+    }
+
+    if (apply_time) {
+        *apply_time = ch_dynamic_att_sched_prv.heap[0].apply_time;
+    }
+    ch_dynamic_att_sched_prv.returned = ch_dynamic_att_sched_prv.heap[0].packet;
+    ch_dynamic_att_sched_prv.heap[0] = ch_dynamic_att_sched_prv.heap[--ch_dynamic_att_sched_prv.count];
+    channel_dynamic_att_sched_sift_down(0U);
+
+    return ch_dynamic_att_sched_prv.returned;
+}
+
+bs_time_t channel_dynamic_att_sched_next_time(void)
+{
+    return ch_dynamic_att_sched_prv.count ? ch_dynamic_att_sched_prv.heap[0].apply_time : TIME_NEVER;
+}
+
+void channel_dynamic_att_sched_delete(void)
+{
+    for (size_t i = 0U; i < ch_dynamic_att_sched_prv.count; i++) {
+        free(ch_dynamic_att_sched_prv.heap[i].packet);
+    }
+    if (ch_dynamic_att_sched_prv.returned) {
+        free(ch_dynamic_att_sched_prv.returned);
+    }
+    if (ch_dynamic_att_sched_prv.heap) {
+        free(ch_dynamic_att_sched_prv.heap);
+    }
+    memset(&ch_dynamic_att_sched_prv, 0, sizeof(ch_dynamic_att_sched_prv));
+}
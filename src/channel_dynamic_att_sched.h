@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_SCHED_H
+#define _CHANNEL_DYNAMIC_ATT_SCHED_H
+
+#include "bs_types.h"
+#include "channel_dynamic_att_com_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Queue a command to be applied at a simulation time
+ *
+ * Commands with the same apply time are returned in the order they were added.
+ *
+ * @param apply_time Simulation time at which the command is due
+ * @param packet Complete command packet. It is copied.
+ */
+void channel_dynamic_att_sched_add(bs_time_t apply_time, const ch_dynamic_att_com_protocol_packet_t *packet);
+
+/**
+ * @brief Take the next command which is due at <now>
+ *
+ * @param now Current simulation time
+ * @param apply_time If not NULL, set to the time the returned command was scheduled for
+ * @return Pointer to the command, valid until the next call, or NULL if no command is due
+ */
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_sched_next(bs_time_t now, bs_time_t *apply_time);
+
+/**
+ * @brief Simulation time of the earliest queued command, or TIME_NEVER if none is queued
+ */
+bs_time_t channel_dynamic_att_sched_next_time(void);
+
+/**
+ * @brief Drop all queued commands and free the queue
+ */
+void channel_dynamic_att_sched_delete(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_SCHED_H */
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+** Include this file before including system headers.  By default, with
+** C99 support from the compiler, it requests POSIX 2008 support.  With
+** C89 support only, it requests POSIX 1997 support.  Override the
+** default behaviour by setting either _XOPEN_SOURCE or _POSIX_C_SOURCE.
+*/
+/* _XOPEN_SOURCE 700 is loosely equivalent to _POSIX_C_SOURCE 200809L */
+/* _XOPEN_SOURCE 600 is loosely equivalent to _POSIX_C_SOURCE 200112L */
+/* _XOPEN_SOURCE 500 is loosely equivalent to _POSIX_C_SOURCE 199506L */
+#if !defined(_XOPEN_SOURCE) && !defined(_POSIX_C_SOURCE)
+#if defined(__cplusplus)
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#elif __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#else
+#define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
+#endif /* __STDC_VERSION__ */
+#endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_matrix.h"
+#include "channel_dynamic_att_position.h"
+#include "channel_dynamic_att_ramp.h"
+#include "channel_dynamic_att_snapshot.h"
+#include "channel_dynamic_att_snapshot_format.h"
+
+void channel_dynamic_att_snapshot_load(const char *file_name, uint num_devices)
+{
+    const ch_dynamic_att_snapshot_header_t *header;
+    struct stat file_stat;
+    size_t map_size;
+    void *map;
+    int fd;
+
+    if (channel_dynamic_att_matrix_num_groups() || channel_dynamic_att_matrix_num_bins() > 1U) {
+        bs_trace_error_line("Attenuation snapshots cannot be loaded with groups or frequency bins\n");
+    }
+
+    fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        bs_trace_error_line("Failed opening attenuation snapshot %s\n", file_name);
+    }
+    if (fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(ch_dynamic_att_snapshot_header_t)) {
+        bs_trace_error_line("Attenuation snapshot %s is too small\n", file_name);
+    }
+
+    map_size = file_stat.st_size;
+    map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        bs_trace_error_line("Failed mapping attenuation snapshot %s\n", file_name);
+    }
+
+    header = map;
+    if (header->magic != DYNAMIC_ATT_SNAPSHOT_MAGIC || header->version != DYNAMIC_ATT_SNAPSHOT_VERSION) {
+        bs_trace_error_line("%s is not a version %u attenuation snapshot\n", file_name, DYNAMIC_ATT_SNAPSHOT_VERSION);
+    }
+    if (header->num_devices != num_devices) {
+        bs_trace_error_line("Attenuation snapshot %s is for %u devices, but the simulation has %u\n",
+                            file_name, header->num_devices, num_devices);
+    }
+    if (map_size < sizeof(*header) + (size_t)num_devices*num_devices*sizeof(double)) {
+        bs_trace_error_line("Attenuation snapshot %s is truncated\n", file_name);
+    }
+
+    channel_dynamic_att_matrix_load((const double *)(header + 1));
+    munmap(map, map_size);
+
+    bs_trace_raw(8, "channel_dynamic_att loaded snapshot %s\n", file_name);
+}
+
+void channel_dynamic_att_snapshot_save(const char *file_name, uint num_devices, double default_attenuation, bs_time_t now)
+{
+    ch_dynamic_att_snapshot_header_t *header;
+    size_t map_size = sizeof(*header) + (size_t)num_devices*num_devices*sizeof(double);
+    char *temp_name;
+    double *matrix;
+    uint *all_tx;
+    void *map;
+    int fd;
+
+    if (channel_dynamic_att_matrix_num_bins() > 1U) {
+        bs_trace_warning_line("Attenuation snapshots cannot be saved with frequency bins, %s not written\n", file_name);
+        return;
+    }
+
+    /* Write to a temporary file and rename it, so the snapshot never appears half written */
+    temp_name = bs_calloc(strlen(file_name) + sizeof(".tmp"), sizeof(char));
+    if (!temp_name) {
+        bs_trace_error("Error allocating memory for snapshot path");
+    }
+    sprintf(temp_name, "%s.tmp", file_name);
+
+    fd = open(temp_name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0 || ftruncate(fd, map_size) != 0) {
+        bs_trace_warning_line("Failed creating attenuation snapshot %s\n", temp_name);
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(temp_name);
+        return;
+    }
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        bs_trace_warning_line("Failed mapping attenuation snapshot %s\n", temp_name);
+        remove(temp_name);
+        free(temp_name);
+        return;
+    }
+
+    header = map;
+    header->magic = DYNAMIC_ATT_SNAPSHOT_MAGIC;
+    header->version = DYNAMIC_ATT_SNAPSHOT_VERSION;
+    header->num_devices = num_devices;
+    header->default_attenuation = default_attenuation;
+    matrix = (double *)(header + 1);
+    all_tx = bs_calloc(num_devices, sizeof(uint));
+    if (!all_tx) {
+        bs_trace_error("Error allocating memory for snapshot");
+    }
+    for (uint tx = 0U; tx < num_devices; tx++) {
+        all_tx[tx] = 1U;
+    }
+    /* Save what channel_calc() would look up now: moved devices recomputed and ramps at their current value */
+    for (uint rx = 0U; rx < num_devices; rx++) {
+        if (channel_dynamic_att_position_is_enabled()) {
+            channel_dynamic_att_position_refresh(rx);
+        }
+        channel_dynamic_att_matrix_copy_row(rx, matrix + (size_t)rx*num_devices);
+        if (channel_dynamic_att_ramp_count()) {
+            channel_dynamic_att_ramp_gather(rx, all_tx, now, matrix + (size_t)rx*num_devices);
+        }
+    }
+    free(all_tx);
+    munmap(map, map_size);
+
+    if (rename(temp_name, file_name) != 0) {
+        bs_trace_warning_line("Failed renaming attenuation snapshot %s to %s\n", temp_name, file_name);
+        remove(temp_name);
+    } else {
+        bs_trace_raw(8, "channel_dynamic_att saved snapshot %s\n", file_name);
+    }
+    free(temp_name);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_SNAPSHOT_H
+#define _CHANNEL_DYNAMIC_ATT_SNAPSHOT_H
+
+#include "bs_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Set the attenuation of all links from a snapshot file
+ *
+ * The file is mapped and copied into the attenuation matrix in one go. Not supported with groups
+ * or frequency bins.
+ *
+ * @param file_name Path of the snapshot file
+ * @param num_devices Number of devices in the simulation, must match the file
+ */
+void channel_dynamic_att_snapshot_load(const char *file_name, uint num_devices);
+
+/**
+ * @brief Save the attenuation of all links to a snapshot file
+ *
+ * Links to devices which moved are recomputed first, and links with a ramp are saved with the
+ * ramp's value at now; the ramps themselves are not saved. The timeline and fading overlays are
+ * not included. Failing to write the file is reported as a warning, the simulation continues. Not
+ * supported with frequency bins.
+ *
+ * @param file_name Path of the snapshot file, replaced if it exists
+ * @param num_devices Number of devices in the simulation
+ * @param default_attenuation Default attenuation of the channel, stored for reference
+ * @param now Current simulation time, for the ramps
+ */
+void channel_dynamic_att_snapshot_save(const char *file_name, uint num_devices, double default_attenuation, bs_time_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_SNAPSHOT_H */
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+** Include this file before including system headers.  By default, with
+** C99 support from the compiler, it requests POSIX 2008 support.  With
+** C89 support only, it requests POSIX 1997 support.  Override the
+** default behaviour by setting either _XOPEN_SOURCE or _POSIX_C_SOURCE.
+*/
+/* _XOPEN_SOURCE 700 is loosely equivalent to _POSIX_C_SOURCE 200809L */
+/* _XOPEN_SOURCE 600 is loosely equivalent to _POSIX_C_SOURCE 200112L */
+/* _XOPEN_SOURCE 500 is loosely equivalent to _POSIX_C_SOURCE 199506L */
+#if !defined(_XOPEN_SOURCE) && !defined(_POSIX_C_SOURCE)
+#if defined(__cplusplus)
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#elif __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#else
+#define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
+#endif /* __STDC_VERSION__ */
+#endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <inttypes.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "bs_oswrap.h"
+#include "bs_tracing.h"
+#include "channel_dynamic_att_com_protocol.h"
+#include "channel_dynamic_att_stats.h"
+
+extern char *pb_com_path;
+
+static ch_dynamic_att_stats_t ch_dynamic_att_stats_local;
+
+ch_dynamic_att_stats_t *ch_dynamic_att_stats = &ch_dynamic_att_stats_local;
+
+static struct {
+    ch_dynamic_att_stats_t *page;
+    char                   *path;
+} ch_dynamic_att_stats_prv = {0};
+
+void channel_dynamic_att_stats_open(const char *fifo_name, uint num_devices)
+{
+    char *path;
+    int fd;
+
+    path = bs_calloc(strlen(pb_com_path) + strlen(fifo_name) + strlen(DYNAMIC_ATT_STATS_SUFFIX) + 2, sizeof(char));
+    if (!path) {
+        bs_trace_error("Error allocating memory for statistics path");
+    }
+    sprintf(path, "%s/%s%s", pb_com_path, fifo_name, DYNAMIC_ATT_STATS_SUFFIX);
+    ch_dynamic_att_stats_prv.path = path;
+
+    /* A new file, a reader may still have the page of an earlier run mapped */
+    remove(path);
+    fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0 || ftruncate(fd, sizeof(ch_dynamic_att_stats_t)) != 0) {
+        /* Not fatal, the counters are still kept and summarized */
+        bs_trace_warning_line("Failed creating statistics page at location %s\n", path);
+    } else {
+        ch_dynamic_att_stats_prv.page = mmap(NULL, sizeof(ch_dynamic_att_stats_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ch_dynamic_att_stats_prv.page == MAP_FAILED) {
+            ch_dynamic_att_stats_prv.page = NULL;
+            bs_trace_warning_line("Failed mapping statistics page at location %s\n", path);
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    memset(&ch_dynamic_att_stats_local, 0, sizeof(ch_dynamic_att_stats_local));
+    ch_dynamic_att_stats = ch_dynamic_att_stats_prv.page ? ch_dynamic_att_stats_prv.page : &ch_dynamic_att_stats_local;
+    ch_dynamic_att_stats->version = DYNAMIC_ATT_STATS_VERSION;
+    ch_dynamic_att_stats->num_devices = num_devices;
+    __atomic_store_n(&ch_dynamic_att_stats->magic, DYNAMIC_ATT_STATS_MAGIC, __ATOMIC_RELEASE);
+}
+
+void channel_dynamic_att_stats_lateness(bs_time_t lateness)
+{
+    uint bucket = 0U;
+
+    while (lateness && bucket < DYNAMIC_ATT_STATS_LATENESS_BUCKETS - 1U) {
+        lateness >>= 1;
+        bucket++;
+    }
+    ch_dynamic_att_stats->lateness[bucket]++;
+}
+
+static void channel_dynamic_att_stats_print(void)
+{
+    const ch_dynamic_att_stats_t *stats = ch_dynamic_att_stats;
+    uint64_t total = 0U;
+
+    for (uint i = 0U; i < DYNAMIC_ATT_STATS_COMMANDS; i++) {
+        total += stats->commands[i];
+    }
+
+    bs_trace_raw(2, "channel_dynamic_att: %"PRIu64" calc calls, %"PRIu64" commands applied, %"PRIu64" bytes read, "
+                 "%"PRIu64"/%"PRIu64" polls empty, %"PRIu64" partial reads, %"PRIu64" malformed (%"PRIu64" bytes skipped)\n",
+                 stats->calc_calls, total, stats->bytes_read, stats->empty_polls, stats->polls,
+                 stats->partial_reads, stats->malformed, stats->skipped_bytes);
+
+    for (uint i = 0U; i < DYNAMIC_ATT_STATS_COMMANDS; i++) {
+        if (stats->commands[i]) {
+            bs_trace_raw(3, "channel_dynamic_att:   command %u: %"PRIu64"\n", i, stats->commands[i]);
+        }
+    }
+    for (uint i = 0U; i < DYNAMIC_ATT_STATS_LATENESS_BUCKETS; i++) {
+        if (stats->lateness[i]) {
+            bs_trace_raw(3, "channel_dynamic_att:   scheduled commands late by %s%"PRIu64" us: %"PRIu64"\n",
+                         i == DYNAMIC_ATT_STATS_LATENESS_BUCKETS - 1U ? ">= " : "< ",
+                         i ? (uint64_t)1U << (i == DYNAMIC_ATT_STATS_LATENESS_BUCKETS - 1U ? i - 1U : i) : 1U,
+                         stats->lateness[i]);
+        }
+    }
+}
+
+void channel_dynamic_att_stats_close(void)
+{
+    channel_dynamic_att_stats_print();
+
+    if (ch_dynamic_att_stats_prv.page) {
+        /* Keep the final values around after the page is gone */
+        memcpy(&ch_dynamic_att_stats_local, ch_dynamic_att_stats_prv.page, sizeof(ch_dynamic_att_stats_local));
+        ch_dynamic_att_stats = &ch_dynamic_att_stats_local;
+        munmap(ch_dynamic_att_stats_prv.page, sizeof(ch_dynamic_att_stats_t));
+        ch_dynamic_att_stats_prv.page = NULL;
+    }
+    if (ch_dynamic_att_stats_prv.path) {
+        remove(ch_dynamic_att_stats_prv.path);
+        free(ch_dynamic_att_stats_prv.path);
+        ch_dynamic_att_stats_prv.path = NULL;
+    }
+}
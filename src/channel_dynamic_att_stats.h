@@ -0,0 +1,54 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_STATS_H
+#define _CHANNEL_DYNAMIC_ATT_STATS_H
+
+#include "bs_types.h"
+#include "channel_dynamic_att_stats_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The counters of the channel. Always valid: before the statistics page is mapped (or if it could
+ * not be) this points to a private copy, so the hot path updates it without checks.
+ */
+extern ch_dynamic_att_stats_t *ch_dynamic_att_stats;
+
+/**
+ * @brief Create and map the statistics page
+ *
+ * Must be called after the com folder has been created.
+ *
+ * @param fifo_name The logical name of the fifo, which the page is named after
+ * @param num_devices Number of devices in the simulation
+ */
+void channel_dynamic_att_stats_open(const char *fifo_name, uint num_devices);
+
+/**
+ * @brief Print a summary of the counters, and unmap and delete the statistics page
+ */
+void channel_dynamic_att_stats_close(void);
+
+/**
+ * @brief Count an applied command
+ */
+static inline void channel_dynamic_att_stats_command(unsigned short command)
+{
+    ch_dynamic_att_stats->commands[command < DYNAMIC_ATT_STATS_COMMANDS ? command : DYNAMIC_ATT_STATS_COMMANDS - 1]++;
+}
+
+/**
+ * @brief Add a scheduled command applied <lateness> after its apply time to the lateness histogram
+ */
+void channel_dynamic_att_stats_lateness(bs_time_t lateness);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_STATS_H */
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+/*
+** Include this file before including system headers.  By default, with
+** C99 support from the compiler, it requests POSIX 2008 support.  With
+** C89 support only, it requests POSIX 1997 support.  Override the
+** default behaviour by setting either _XOPEN_SOURCE or _POSIX_C_SOURCE.
+*/
+/* _XOPEN_SOURCE 700 is loosely equivalent to _POSIX_C_SOURCE 200809L */
+/* _XOPEN_SOURCE 600 is loosely equivalent to _POSIX_C_SOURCE 200112L */
+/* _XOPEN_SOURCE 500 is loosely equivalent to _POSIX_C_SOURCE 199506L */
+#if !defined(_XOPEN_SOURCE) && !defined(_POSIX_C_SOURCE)
+#if defined(__cplusplus)
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#elif __STDC_VERSION__ >= 199901L
+#define _XOPEN_SOURCE 700   /* SUS v4, POSIX 1003.1 2008/13 (POSIX 2008/13) */
+#else
+#define _XOPEN_SOURCE 500   /* SUS v2, POSIX 1003.1 1997 */
+#endif /* __STDC_VERSION__ */
+#endif /* !_XOPEN_SOURCE && !_POSIX_C_SOURCE */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_timeline.h"
+#include "channel_dynamic_att_timeline_format.h"
+
+/*
+ * The timeline file is mapped read only and evaluated lazily: the link table row for a receiver
+ * is only scanned the first time that receiver is looked up, and a link's points are only read
+ * when that link has an active transmitter. Each link keeps a cursor to the point at or before
+ * the last evaluated time, so evaluation is amortized constant time while time moves forward.
+ */
+
+typedef enum {
+    DYNAMIC_ATT_TIMELINE_ROW_UNKNOWN = 0,
+    DYNAMIC_ATT_TIMELINE_ROW_EMPTY,
+    DYNAMIC_ATT_TIMELINE_ROW_USED,
+} ch_dynamic_att_timeline_row_state_t;
+
+static struct {
+    void                                  *map;
+    size_t                                 map_size;
+    uint                                   num_devices;
+    const ch_dynamic_att_timeline_header_t *header;
+    const ch_dynamic_att_timeline_link_t   *links;
+    const ch_dynamic_att_timeline_point_t  *points;
+    uint32_t                              *cursors;
+    unsigned char                         *row_state;
+} ch_dynamic_att_timeline_prv = {0};
+
+void channel_dynamic_att_timeline_open(const char *file_name, uint num_devices)
+{
+    struct stat file_stat;
+    size_t links_size;
+    int fd;
+
+    fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        bs_trace_error_line("Failed opening attenuation timeline %s\n", file_name);
+    }
+    if (fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(ch_dynamic_att_timeline_header_t)) {
+        bs_trace_error_line("Attenuation timeline %s is too small\n", file_name);
+    }
+
+    ch_dynamic_att_timeline_prv.map_size = file_stat.st_size;
+    ch_dynamic_att_timeline_prv.map = mmap(NULL, ch_dynamic_att_timeline_prv.map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ch_dynamic_att_timeline_prv.map == MAP_FAILED) {
+        bs_trace_error_line("Failed mapping attenuation timeline %s\n", file_name);
+    }
+
+    ch_dynamic_att_timeline_prv.header = ch_dynamic_att_timeline_prv.map;
+    if (ch_dynamic_att_timeline_prv.header->magic != DYNAMIC_ATT_TIMELINE_MAGIC ||
+        ch_dynamic_att_timeline_prv.header->version != DYNAMIC_ATT_TIMELINE_VERSION) {
+        bs_trace_error_line("%s is not a version %u attenuation timeline\n", file_name, DYNAMIC_ATT_TIMELINE_VERSION);
+    }
+    if (ch_dynamic_att_timeline_prv.header->num_devices != num_devices) {
+        bs_trace_error_line("Attenuation timeline %s is for %u devices, but the simulation has %u\n",
+                            file_name, ch_dynamic_att_timeline_prv.header->num_devices, num_devices);
+    }
+    links_size = (size_t)num_devices*num_devices*sizeof(ch_dynamic_att_timeline_link_t);
+    /* Checked by division, so a huge num_points cannot wrap around */
+    if (ch_dynamic_att_timeline_prv.map_size < sizeof(ch_dynamic_att_timeline_header_t) + links_size ||
+        ch_dynamic_att_timeline_prv.header->num_points > (ch_dynamic_att_timeline_prv.map_size - sizeof(ch_dynamic_att_timeline_header_t) - links_size)/
+                                                         sizeof(ch_dynamic_att_timeline_point_t)) {
+        bs_trace_error_line("Attenuation timeline %s is truncated\n", file_name);
+    }
+
+    ch_dynamic_att_timeline_prv.num_devices = num_devices;
+    ch_dynamic_att_timeline_prv.links = (const ch_dynamic_att_timeline_link_t *)(ch_dynamic_att_timeline_prv.header + 1);
+    ch_dynamic_att_timeline_prv.points = (const ch_dynamic_att_timeline_point_t *)((const char *)ch_dynamic_att_timeline_prv.links + links_size);
+
+    /* Zero filled on demand by the OS, so only cursors of links in use cost memory */
+    ch_dynamic_att_timeline_prv.cursors = bs_calloc((size_t)num_devices*num_devices, sizeof(uint32_t));
+    ch_dynamic_att_timeline_prv.row_state = bs_calloc(num_devices, sizeof(unsigned char));
+    if (!ch_dynamic_att_timeline_prv.cursors || !ch_dynamic_att_timeline_prv.row_state) {
+        bs_trace_error("Error allocating memory for attenuation timeline");
+    }
+
+    bs_trace_raw(8, "channel_dynamic_att mapped timeline %s with %"PRIu64" points\n",
+                 file_name, ch_dynamic_att_timeline_prv.header->num_points);
+}
+
+void channel_dynamic_att_timeline_close(void)
+{
+    if (ch_dynamic_att_timeline_prv.map) {
+        munmap(ch_dynamic_att_timeline_prv.map, ch_dynamic_att_timeline_prv.map_size);
+        free(ch_dynamic_att_timeline_prv.cursors);
+        free(ch_dynamic_att_timeline_prv.row_state);
+        ch_dynamic_att_timeline_prv.map = NULL;
+        ch_dynamic_att_timeline_prv.cursors = NULL;
+        ch_dynamic_att_timeline_prv.row_state = NULL;
+    }
+}
+
+bool channel_dynamic_att_timeline_is_open(void)
+{
+    return ch_dynamic_att_timeline_prv.map != NULL;
+}
+
+/*
+ * Find out, once per receiver, if any link towards it has a timeline
+ */
+static bool channel_dynamic_att_timeline_row_used(uint rx)
+{
+    const ch_dynamic_att_timeline_link_t *row;
+
+    if (ch_dynamic_att_timeline_prv.row_state[rx] == DYNAMIC_ATT_TIMELINE_ROW_UNKNOWN) {
+        ch_dynamic_att_timeline_prv.row_state[rx] = DYNAMIC_ATT_TIMELINE_ROW_EMPTY;
+        row = ch_dynamic_att_timeline_prv.links + (size_t)rx*ch_dynamic_att_timeline_prv.num_devices;
+        for (uint tx = 0U; tx < ch_dynamic_att_timeline_prv.num_devices; tx++) {
+            if (row[tx].count == 0U) {
+                continue;
+            }
+            if (row[tx].first_point > ch_dynamic_att_timeline_prv.header->num_points ||
+                row[tx].count > ch_dynamic_att_timeline_prv.header->num_points - row[tx].first_point) {
+                bs_trace_error_line("Attenuation timeline for link %u->%u is out of bounds\n", tx, rx);
+            }
+            ch_dynamic_att_timeline_prv.row_state[rx] = DYNAMIC_ATT_TIMELINE_ROW_USED;
+        }
+    }
+    return ch_dynamic_att_timeline_prv.row_state[rx] == DYNAMIC_ATT_TIMELINE_ROW_USED;
+}
+
+static double channel_dynamic_att_timeline_eval(size_t link_index, bs_time_t now)
+{
+    const ch_dynamic_att_timeline_link_t *link = &ch_dynamic_att_timeline_prv.links[link_index];
+    const ch_dynamic_att_timeline_point_t *points = ch_dynamic_att_timeline_prv.points + link->first_point;
+    uint32_t cursor = ch_dynamic_att_timeline_prv.cursors[link_index];
+
+    if (cursor >= link->count || points[cursor].time > now) {
+        /* Time moved backwards (or first use), restart from the beginning */
+        cursor = 0U;
+    }
+    while (cursor + 1U < link->count && points[cursor + 1U].time <= now) {
+        cursor++;
+    }
+    ch_dynamic_att_timeline_prv.cursors[link_index] = cursor;
+
+    if (cursor + 1U == link->count || now <= points[cursor].time) {
+        return points[cursor].attenuation;
+    }
+    return points[cursor].attenuation + (points[cursor + 1U].attenuation - points[cursor].attenuation) *
+           (double)(now - points[cursor].time) / (double)(points[cursor + 1U].time - points[cursor].time);
+}
+
+void channel_dynamic_att_timeline_gather(uint rx, const uint *tx_used, bs_time_t now, double *att)
+{
+    size_t row_index = (size_t)rx*ch_dynamic_att_timeline_prv.num_devices;
+
+    if (!channel_dynamic_att_timeline_row_used(rx)) {
+        return;
+    }
+
+    for (uint tx = 0U; tx < ch_dynamic_att_timeline_prv.num_devices; tx++) {
+        if (tx_used[tx] && ch_dynamic_att_timeline_prv.links[row_index + tx].count) {
+            att[tx] = channel_dynamic_att_timeline_eval(row_index + tx, now);
+        }
+    }
+}
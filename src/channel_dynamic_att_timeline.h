@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_TIMELINE_H
+#define _CHANNEL_DYNAMIC_ATT_TIMELINE_H
+
+#include "bs_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Map an attenuation timeline file
+ *
+ * The file is only mapped, links are read the first time they are looked up.
+ *
+ * @param file_name Path of the timeline file
+ * @param num_devices Number of devices in the simulation, must match the file
+ */
+void channel_dynamic_att_timeline_open(const char *file_name, uint num_devices);
+
+/**
+ * @brief Unmap the timeline file, if any
+ */
+void channel_dynamic_att_timeline_close(void);
+
+/**
+ * @brief True if a timeline file is mapped
+ */
+bool channel_dynamic_att_timeline_is_open(void);
+
+/**
+ * @brief Overwrite the attenuation of active transmitters which have a timeline towards rx
+ *
+ * @param rx      The receiving device
+ * @param tx_used Array with num_devices elements, non-zero for active transmitters
+ * @param now     Current simulation time
+ * @param att     Array with num_devices elements
+ */
+void channel_dynamic_att_timeline_gather(uint rx, const uint *tx_used, bs_time_t now, double *att);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_TIMELINE_H */
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include "bs_types.h"
+#include "bs_tracing.h"
+#include "bs_oswrap.h"
+#include "channel_dynamic_att_txn.h"
+
+/*
+ * Commands of a device inside a transaction are copied, back to back as received, to a buffer of
+ * that device. A commit hands them back in order, so they are all applied between the same two
+ * channel evaluations, and the buffer is kept for the next transaction of the device.
+ */
+
+#define DYNAMIC_ATT_TXN_MIN_CAPACITY (1024U)
+
+typedef struct {
+    unsigned char *buffer;
+    size_t         used;
+    size_t         capacity;
+    size_t         next;     /* Offset of the next command to take after a commit */
+    bool           open;
+} ch_dynamic_att_txn_t;
+
+static struct {
+    ch_dynamic_att_txn_t *txn;
+    uint                  num_devices;
+    uint                  open_count;
+} ch_dynamic_att_txn_prv = {0};
+
+void channel_dynamic_att_txn_init(uint num_devices)
+{
+    ch_dynamic_att_txn_prv.txn = bs_calloc(num_devices, sizeof(ch_dynamic_att_txn_t));
+    if (!ch_dynamic_att_txn_prv.txn) {
+        bs_trace_error("Error allocating memory for transactions");
+    }
+    ch_dynamic_att_txn_prv.num_devices = num_devices;
+    ch_dynamic_att_txn_prv.open_count = 0U;
+}
+
+void channel_dynamic_att_txn_delete(void)
+{
+    if (!ch_dynamic_att_txn_prv.txn) {
+        return;
+    }
+    for (uint device = 0U; device < ch_dynamic_att_txn_prv.num_devices; device++) {
+        ch_dynamic_att_txn_t *txn = &ch_dynamic_att_txn_prv.txn[device];
+
+        if (txn->open) {
+            bs_trace_warning_line("Device %u never committed its transaction, %zu bytes of commands were dropped\n", device, txn->used);
+        }
+        free(txn->buffer);
+    }
+    free(ch_dynamic_att_txn_prv.txn);
+    memset(&ch_dynamic_att_txn_prv, 0, sizeof(ch_dynamic_att_txn_prv));
+}
+
+uint channel_dynamic_att_txn_open_count(void)
+{
+    return ch_dynamic_att_txn_prv.open_count;
+}
+
+bool channel_dynamic_att_txn_is_open(uint device)
+{
+    return device < ch_dynamic_att_txn_prv.num_devices && ch_dynamic_att_txn_prv.txn[device].open;
+}
+
+void channel_dynamic_att_txn_begin(uint device)
+{
+    ch_dynamic_att_txn_t *txn = &ch_dynamic_att_txn_prv.txn[device];
+
+    if (txn->open) {
+        bs_trace_warning_line_time("Device %u began a transaction inside its open transaction, which continues\n", device);
+        return;
+    }
+    txn->open = true;
+    txn->used = 0U;
+    txn->next = 0U;
+    ch_dynamic_att_txn_prv.open_count++;
+}
+
+void channel_dynamic_att_txn_hold(uint device, const ch_dynamic_att_com_protocol_packet_t *packet)
+{
+    ch_dynamic_att_txn_t *txn = &ch_dynamic_att_txn_prv.txn[device];
+    size_t packet_size = sizeof(packet->header) + packet->header.payload_size;
+
+    if (txn->used + packet_size > txn->capacity) {
+        txn->capacity = txn->capacity ? txn->capacity : DYNAMIC_ATT_TXN_MIN_CAPACITY;
+        while (txn->used + packet_size > txn->capacity) {
+            txn->capacity *= 2U;
+        }
+        txn->buffer = bs_realloc(txn->buffer, txn->capacity);
+        if (!txn->buffer) {
+            bs_trace_error("Error allocating memory for transaction commands");
+        }
+    }
+    memcpy(txn->buffer + txn->used, packet, packet_size);
+    txn->used += packet_size;
+}
+
+bool channel_dynamic_att_txn_commit(uint device)
+{
+    ch_dynamic_att_txn_t *txn = &ch_dynamic_att_txn_prv.txn[device];
+
+    if (!txn->open) {
+        return false;
+    }
+    txn->open = false;
+    txn->next = 0U;
+    ch_dynamic_att_txn_prv.open_count--;
+    return true;
+}
+
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_txn_next(uint device)
+{
+    ch_dynamic_att_txn_t *txn = &ch_dynamic_att_txn_prv.txn[device];
+    const ch_dynamic_att_com_protocol_packet_t *packet;
+
+    if (txn->open) {
+        return NULL;
+    }
+    if (txn->next >= txn->used) {
+        txn->used = 0U;
+        txn->next = 0U;
+        return NULL;
+    }
+    packet = (const ch_dynamic_att_com_protocol_packet_t *)(txn->buffer + txn->next);
+    txn->next += sizeof(packet->header) + packet->header.payload_size;
+    return packet;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 Oticon A/S
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CHANNEL_DYNAMIC_ATT_TXN_H
+#define _CHANNEL_DYNAMIC_ATT_TXN_H
+
+#include "bs_types.h"
+#include "channel_dynamic_att_com_protocol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Allocate the transaction state of num_devices devices
+ */
+void channel_dynamic_att_txn_init(uint num_devices);
+
+/**
+ * @brief Drop all open transactions and free their commands
+ */
+void channel_dynamic_att_txn_delete(void);
+
+/**
+ * @brief Number of devices with an open transaction
+ */
+uint channel_dynamic_att_txn_open_count(void);
+
+/**
+ * @brief True if device has an open transaction
+ */
+bool channel_dynamic_att_txn_is_open(uint device);
+
+/**
+ * @brief Open a transaction for device. Its commands are then held until it is committed.
+ */
+void channel_dynamic_att_txn_begin(uint device);
+
+/**
+ * @brief Hold a command of a device with an open transaction
+ *
+ * @param device The device
+ * @param packet Complete command packet. It is copied.
+ */
+void channel_dynamic_att_txn_hold(uint device, const ch_dynamic_att_com_protocol_packet_t *packet);
+
+/**
+ * @brief Close the transaction of device, so its held commands can be taken with
+ *        @ref channel_dynamic_att_txn_next
+ *
+ * @return False if device had no open transaction
+ */
+bool channel_dynamic_att_txn_commit(uint device);
+
+/**
+ * @brief Take the next held command of a committed transaction, in the order they were held
+ *
+ * @param device The device
+ * @return Pointer to the command, valid until the transaction state of the device changes, or
+ *         NULL when all held commands have been taken
+ */
+const ch_dynamic_att_com_protocol_packet_t *channel_dynamic_att_txn_next(uint device);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHANNEL_DYNAMIC_ATT_TXN_H */